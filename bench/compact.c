@@ -0,0 +1,190 @@
+/* Compare the memory taken per element and the speed of walking, reversing
+ * and sorting a queue of element_t against the XOR-linked queue of
+ * xorlist.h. Each one runs in a process of its own, so that the resident
+ * size it adds is measured from the same start.
+ *
+ * Usage: bench/compact [n]    (default: 10^7)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+#include "xorlist.h"
+
+/* Room for the random strings qtest generates, plus the terminator */
+#define STRLEN_MAX 16
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_random(char *buf)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
+    int len = 5 + rand() % 5;
+    for (int i = 0; i < len; i++)
+        buf[i] = charset[rand() % (sizeof(charset) - 1)];
+    buf[len] = '\0';
+}
+
+/* Resident size of the process in bytes */
+static size_t resident(void)
+{
+    unsigned long size, rss = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%lu %lu", &size, &rss) != 2)
+            rss = 0;
+        fclose(f);
+    }
+    return rss * sysconf(_SC_PAGESIZE);
+}
+
+/* Where the memory a queue takes goes */
+struct footprint {
+    size_t rss, bytes, blocks;
+};
+
+static struct footprint footprint(void)
+{
+    return (struct footprint){resident(), allocation_bytes(),
+                              allocation_check()};
+}
+
+static void report_memory(struct footprint before, int n)
+{
+    struct footprint after = footprint();
+
+    /* The harness wraps a header and a footer around each block */
+    size_t blocks = after.blocks - before.blocks;
+    void *probe = test_malloc(1);
+    size_t wrap = allocation_bytes() - after.bytes - 1;
+    test_free(probe);
+
+    printf("%-14s %12.2f bytes/element\n", "payload",
+           (double) (after.bytes - before.bytes - blocks * wrap) / n);
+    printf("%-14s %12.2f bytes/element, harness blocks included\n",
+           "resident", (double) (after.rss - before.rss) / n);
+}
+
+static void report_op(const char *op, double t0, double t1, int n)
+{
+    printf("%-14s %12.2f ns/element\n", op, (t1 - t0) / n);
+}
+
+static void run_list(int n)
+{
+    char buf[STRLEN_MAX];
+    struct footprint before = footprint();
+    struct list_head *q = q_new();
+    double t0 = now();
+    for (int i = 0; i < n; i++) {
+        fill_random(buf);
+        q_insert_tail(q, buf);
+    }
+    double t1 = now();
+    printf("element_t, %zu bytes per node\n", sizeof(element_t));
+    report_op("insert_tail", t0, t1, n);
+    report_memory(before, n);
+
+    unsigned long sum = 0;
+    element_t *e;
+    t0 = now();
+    list_for_each_entry (e, q, list)
+        sum += e->value[0];
+    t1 = now();
+    report_op("walk", t0, t1, n);
+    t0 = now();
+    for (struct list_head *node = q->prev; node != q; node = node->prev)
+        sum += list_entry(node, element_t, list)->value[0];
+    t1 = now();
+    report_op("walk back", t0, t1, n);
+
+    t0 = now();
+    q_reverse(q);
+    t1 = now();
+    report_op("reverse", t0, t1, n);
+    t0 = now();
+    q_sort(q, false);
+    t1 = now();
+    report_op("sort", t0, t1, n);
+    printf("%-14s %12lu\n", "checksum", sum);
+    q_free(q);
+}
+
+static void run_xor(int n)
+{
+    char buf[STRLEN_MAX];
+    struct footprint before = footprint();
+    xqueue_t *q = xq_new();
+    double t0 = now();
+    for (int i = 0; i < n; i++) {
+        fill_random(buf);
+        xq_insert_tail(q, buf);
+    }
+    double t1 = now();
+    printf("xnode_t, %zu bytes per node\n", sizeof(xnode_t));
+    report_op("insert_tail", t0, t1, n);
+    report_memory(before, n);
+
+    unsigned long sum = 0;
+    xq_iter_t it;
+    t0 = now();
+    xq_for_each (it, q)
+        sum += it.cur->value[0];
+    t1 = now();
+    report_op("walk", t0, t1, n);
+    t0 = now();
+    xq_for_each_reverse (it, q)
+        sum += it.cur->value[0];
+    t1 = now();
+    report_op("walk back", t0, t1, n);
+
+    t0 = now();
+    xq_reverse(q);
+    t1 = now();
+    report_op("reverse", t0, t1, n);
+    t0 = now();
+    xq_sort(q, false);
+    t1 = now();
+    report_op("sort", t0, t1, n);
+    printf("%-14s %12lu\n", "checksum", sum);
+    xq_free(q);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+
+    /* Count the harness out of what is measured, as far as it goes */
+    set_cautious_mode(false);
+    printf("n = %d\n", n);
+    for (int xor = 0; xor <= 1; xor++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (!pid) {
+            srand(1);
+            if (xor)
+                run_xor(n);
+            else
+                run_list(n);
+            fflush(stdout);
+            _exit(0);
+        }
+        waitpid(pid, NULL, 0);
+    }
+    return 0;
+}
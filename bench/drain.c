@@ -0,0 +1,98 @@
+/* Compare draining a queue one q_remove_head() at a time against batches of
+ * q_remove_head_n() into a 64 KiB arena, in elements per second.
+ *
+ * Usage: bench/drain [n]    (default: 10^6)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+#define ARENA_SIZE 65536
+
+/* Room for the random strings qtest generates, plus the terminator */
+#define STRLEN_MAX 16
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_random(char *buf)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
+    int len = 5 + rand() % 5;
+    for (int i = 0; i < len; i++)
+        buf[i] = charset[rand() % (sizeof(charset) - 1)];
+    buf[len] = '\0';
+}
+
+/* Queue the strings of @sv and return the time taken to drain it, in seconds;
+ * @sink accumulates the first byte of every removed string
+ */
+static double drain(char **sv, int n, bool batched, unsigned *sink)
+{
+    struct list_head *q = q_new();
+    q_insert_tail_bulk(q, sv, n);
+
+    char *arena_buf = malloc(ARENA_SIZE);
+    size_t *offsets = malloc(ARENA_SIZE * sizeof(size_t));
+    q_arena_t arena = {arena_buf, ARENA_SIZE};
+    char sp[STRLEN_MAX];
+
+    double t0 = now();
+    if (batched) {
+        int got;
+        while ((got = q_remove_head_n(q, ARENA_SIZE, offsets, &arena)) > 0) {
+            for (int i = 0; i < got; i++)
+                *sink += (unsigned char) arena_buf[offsets[i]];
+        }
+    } else {
+        element_t *e;
+        while ((e = q_remove_head(q, sp, sizeof(sp)))) {
+            q_release_element(e);
+            *sink += (unsigned char) sp[0];
+        }
+    }
+    double t = (now() - t0) / 1e9;
+
+    free(offsets);
+    free(arena_buf);
+    q_free(q);
+    return t;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    char *pool = malloc((size_t) n * STRLEN_MAX);
+    char **sv = malloc(n * sizeof(*sv));
+    if (!pool || !sv) {
+        fprintf(stderr, "Could not allocate %d strings\n", n);
+        return 1;
+    }
+    for (int i = 0; i < n; i++) {
+        sv[i] = pool + (size_t) i * STRLEN_MAX;
+        fill_random(sv[i]);
+    }
+
+    /* Count the harness out of what is measured, as far as it goes */
+    set_cautious_mode(false);
+
+    unsigned sink = 0;
+    double single = drain(sv, n, false, &sink);
+    double batched = drain(sv, n, true, &sink);
+    printf("n = %d (checksum %u)\n", n, sink);
+    printf("%-16s %12.2f M elements/s\n", "q_remove_head", n / single / 1e6);
+    printf("%-16s %12.2f M elements/s\n", "q_remove_head_n", n / batched / 1e6);
+
+    free(sv);
+    free(pool);
+    return 0;
+}
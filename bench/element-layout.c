@@ -0,0 +1,103 @@
+/* Measure insert/free throughput and the per-element footprint of queue
+ * elements, comparing the single-allocation element_t against the former
+ * layout that allocated the node and its string separately.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Account memory through the harness the same way qtest does */
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+/* Previous layout: node and string are two independent blocks */
+typedef struct {
+    char *value;
+    struct list_head list;
+} split_element_t;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static bool split_insert_tail(struct list_head *head, const char *s)
+{
+    split_element_t *e = test_malloc(sizeof(split_element_t));
+    if (!e)
+        return false;
+    size_t len = strlen(s) + 1;
+    e->value = test_malloc(len);
+    if (!e->value) {
+        test_free(e);
+        return false;
+    }
+    memcpy(e->value, s, len);
+    list_add_tail(&e->list, head);
+    return true;
+}
+
+static void split_free(struct list_head *head)
+{
+    split_element_t *e, *safe;
+    list_for_each_entry_safe (e, safe, head, list) {
+        test_free(e->value);
+        test_free(e);
+    }
+}
+
+static void bench_split(int n, const char *s)
+{
+    LIST_HEAD(head);
+    size_t base = allocation_bytes();
+
+    double t0 = now();
+    for (int i = 0; i < n; i++)
+        split_insert_tail(&head, s);
+    double t1 = now();
+    size_t bytes = allocation_bytes() - base;
+    split_free(&head);
+    double t2 = now();
+
+    printf("%-8s %9d %12.1f %12.1f %12.1f\n", "split", n, (t1 - t0) / n,
+           (t2 - t1) / n, (double) bytes / n);
+}
+
+static void bench_inline(int n, char *s)
+{
+    size_t base = allocation_bytes();
+    struct list_head *q = q_new();
+    size_t qbytes = allocation_bytes() - base;
+
+    double t0 = now();
+    for (int i = 0; i < n; i++)
+        q_insert_tail(q, s);
+    double t1 = now();
+    size_t bytes = allocation_bytes() - base - qbytes;
+    q_free(q);
+    double t2 = now();
+
+    printf("%-8s %9d %12.1f %12.1f %12.1f\n", "inline", n, (t1 - t0) / n,
+           (t2 - t1) / n, (double) bytes / n);
+}
+
+int main(int argc, char *argv[])
+{
+    char *s = argc > 1 ? argv[1] : "dolphin";
+
+    /* The linear search for a block on every free is not what we measure */
+    set_cautious_mode(false);
+
+    printf("%-8s %9s %12s %12s %12s\n", "layout", "n", "insert ns/e",
+           "free ns/e", "bytes/e");
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        bench_split(n, s);
+        bench_inline(n, s);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+/* Compare inserting n copies of a string one q_insert_tail() at a time
+ * against a single q_insert_tail_bulk() call, then freeing the queue.
+ *
+ * Only the queue calls are timed. qtest's "it str n" takes the bulk path with
+ * "option bulk 1" alone, and checks every element it inserts either way,
+ * which narrows the gap between the two.
+ *
+ * Usage: bench/insert [n]    (default: 10^6)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    char *s = "gerbil";
+    char **sv = malloc(n * sizeof(*sv));
+    if (!sv) {
+        fprintf(stderr, "Could not allocate %d strings\n", n);
+        return 1;
+    }
+    for (int i = 0; i < n; i++)
+        sv[i] = s;
+
+    /* Count the harness out of what is measured, as far as it goes */
+    set_cautious_mode(false);
+
+    printf("n = %d\n%-8s %14s %14s\n", n, "insert", "insert ns/elem",
+           "free ns/elem");
+    for (int bulk = 0; bulk <= 1; bulk++) {
+        struct list_head *q = q_new();
+        double t0 = now();
+        if (bulk) {
+            q_insert_tail_bulk(q, sv, n);
+        } else {
+            for (int i = 0; i < n; i++)
+                q_insert_tail(q, s);
+        }
+        double t1 = now();
+        if (q_size(q) != n) {
+            fprintf(stderr, "queue holds %d elements\n", q_size(q));
+            return 1;
+        }
+        q_free(q);
+        double t2 = now();
+        printf("%-8s %14.2f %14.2f\n", bulk ? "bulk" : "single", (t1 - t0) / n,
+               (t2 - t1) / n);
+    }
+
+    free(sv);
+    return 0;
+}
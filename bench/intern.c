@@ -0,0 +1,73 @@
+/* Insert n copies each of two strings, as trace-14-perf does, with and
+ * without the intern pool, and report the memory the queue takes at its peak
+ * along with the time to insert and to drop the duplicates.
+ *
+ * Usage: bench/intern [n]    (default: 10^6)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    /* Count the harness out of what is measured, as far as it goes */
+    set_cautious_mode(false);
+
+    printf("n = %d\n%-8s %-6s %14s %14s %14s\n", 2 * n, "pool", "insert",
+           "peak bytes", "insert ns/elem", "dedup ns/elem");
+    for (int bulk = 0; bulk <= 1; bulk++) {
+        char **sv[2] = {malloc(n * sizeof(char *)), malloc(n * sizeof(char *))};
+        if (!sv[0] || !sv[1]) {
+            fprintf(stderr, "Could not allocate %d strings\n", n);
+            return 1;
+        }
+        for (int i = 0; i < n; i++) {
+            sv[0][i] = "dolphin";
+            sv[1][i] = "gerbil";
+        }
+
+        for (q_intern_strings = 0; q_intern_strings <= 1; q_intern_strings++) {
+            size_t bytes = allocation_bytes();
+            struct list_head *q = q_new();
+            double t0 = now();
+            if (bulk) {
+                q_insert_head_bulk(q, sv[0], n);
+                q_insert_tail_bulk(q, sv[1], n);
+            } else {
+                for (int i = 0; i < n; i++)
+                    q_insert_head(q, sv[0][i]);
+                for (int i = 0; i < n; i++)
+                    q_insert_tail(q, sv[1][i]);
+            }
+            double t1 = now();
+            size_t peak = allocation_bytes() - bytes;
+            q_delete_dup(q);
+            double t2 = now();
+            if (q_size(q)) {
+                fprintf(stderr, "queue holds %d elements\n", q_size(q));
+                return 1;
+            }
+            q_free(q);
+            printf("%-8s %-6s %14zu %14.2f %14.2f\n",
+                   q_intern_strings ? "on" : "off", bulk ? "bulk" : "single",
+                   peak, (t1 - t0) / (2 * n), (t2 - t1) / (2 * n));
+        }
+        free(sv[0]);
+        free(sv[1]);
+    }
+    return 0;
+}
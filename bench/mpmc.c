@@ -0,0 +1,101 @@
+/* Compare the throughput of the lock-free queue of mpmc.h with a list.h
+ * queue behind a mutex, on 1 to 16 threads each enqueuing an element then
+ * dequeuing one, over and over.
+ *
+ * Usage: bench/mpmc [ops]    (default: 10^6 pairs per thread)
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "mpmc.h"
+
+struct locked_queue {
+    pthread_mutex_t lock;
+    struct list_head head;
+};
+
+struct worker {
+    pthread_t tid;
+    mpmc_t *mpmc;
+    struct locked_queue *locked;
+    element_t e;
+    long ops;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Each thread brings one element along, so dequeues never find the queue
+ * empty
+ */
+static void *run_mpmc(void *arg)
+{
+    struct worker *w = arg;
+    int slot = mpmc_attach(w->mpmc);
+    element_t *e = &w->e;
+    for (long i = 0; i < w->ops; i++) {
+        mpmc_enqueue(w->mpmc, slot, e);
+        e = mpmc_dequeue(w->mpmc, slot);
+    }
+    mpmc_detach(w->mpmc, slot);
+    return NULL;
+}
+
+static void *run_locked(void *arg)
+{
+    struct worker *w = arg;
+    struct locked_queue *q = w->locked;
+    element_t *e = &w->e;
+    for (long i = 0; i < w->ops; i++) {
+        pthread_mutex_lock(&q->lock);
+        list_add_tail(&e->list, &q->head);
+        pthread_mutex_unlock(&q->lock);
+
+        pthread_mutex_lock(&q->lock);
+        e = list_first_entry(&q->head, element_t, list);
+        list_del(&e->list);
+        pthread_mutex_unlock(&q->lock);
+    }
+    return NULL;
+}
+
+/* Million operations per second of @nthreads threads running @fn */
+static double measure(void *(*fn)(void *), int nthreads, long ops)
+{
+    struct worker w[16];
+    struct locked_queue locked = {PTHREAD_MUTEX_INITIALIZER};
+    INIT_LIST_HEAD(&locked.head);
+    mpmc_t *mpmc = mpmc_new();
+
+    double t0 = now();
+    for (int i = 0; i < nthreads; i++) {
+        w[i] = (struct worker){.mpmc = mpmc, .locked = &locked, .ops = ops};
+        pthread_create(&w[i].tid, NULL, fn, &w[i]);
+    }
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(w[i].tid, NULL);
+    double t1 = now();
+
+    mpmc_free(mpmc);
+    return 2.0 * ops * nthreads / (t1 - t0) * 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    long ops = argc > 1 ? atol(argv[1]) : 1000000;
+
+    printf("%-8s %16s %16s\n", "threads", "lock-free Mop/s", "mutex Mop/s");
+    for (int t = 1; t <= 16; t *= 2)
+        printf("%-8d %16.2f %16.2f\n", t, measure(run_mpmc, t, ops),
+               measure(run_locked, t, ops));
+    return 0;
+}
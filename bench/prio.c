@@ -0,0 +1,102 @@
+/* Feed a queue of n random strings with ops more, taking the least string
+ * out after each one: once by sorting the queue and removing its head, once
+ * through the pairing heap of q_insert_prio() and q_remove_min(). The heap
+ * is built from the queue on the first removal, which is timed as well.
+ *
+ * Usage: bench/prio [n [ops]]    (default: 10^4 10^3)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+/* Room for the random strings qtest generates, plus the terminator */
+#define STRLEN_MAX 16
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_random(char *buf)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
+    int len = 5 + rand() % 5;
+    for (int i = 0; i < len; i++)
+        buf[i] = charset[rand() % (sizeof(charset) - 1)];
+    buf[len] = '\0';
+}
+
+/* Run the workload, writing the strings taken out to @out, and return the
+ * time taken per operation
+ */
+static double run(const char *pool, int n, int ops, bool heap, char *out)
+{
+    struct list_head *q = q_new();
+    for (int i = 0; i < n; i++)
+        q_insert_tail(q, (char *) pool + (size_t) i * STRLEN_MAX);
+
+    double t0 = now();
+    for (int i = 0; i < ops; i++) {
+        char *s = (char *) pool + (size_t) (n + i) * STRLEN_MAX;
+        char *sp = out + (size_t) i * STRLEN_MAX;
+        element_t *e;
+        if (heap) {
+            q_insert_prio(q, s);
+            e = q_remove_min(q, sp, STRLEN_MAX);
+        } else {
+            q_insert_tail(q, s);
+            q_sort(q, false);
+            e = q_remove_head(q, sp, STRLEN_MAX);
+        }
+        q_release_element(e);
+    }
+    double t1 = now();
+
+    q_free(q);
+    return (t1 - t0) / ops;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 10000;
+    int ops = argc > 2 ? atoi(argv[2]) : 1000;
+    char *pool = malloc((size_t) (n + ops) * STRLEN_MAX);
+    char *out[2] = {malloc((size_t) ops * STRLEN_MAX),
+                    malloc((size_t) ops * STRLEN_MAX)};
+    if (!pool || !out[0] || !out[1]) {
+        fprintf(stderr, "Could not allocate %d strings\n", n + ops);
+        return 1;
+    }
+
+    /* Count the harness out of what is measured, as far as it goes */
+    set_cautious_mode(false);
+    srand(1);
+    for (int i = 0; i < n + ops; i++)
+        fill_random(pool + (size_t) i * STRLEN_MAX);
+
+    printf("n = %d, ops = %d\n", n, ops);
+    double sort = run(pool, n, ops, false, out[0]);
+    printf("%-24s %14.2f ns/op\n", "sort + remove_head", sort);
+    double heap = run(pool, n, ops, true, out[1]);
+    printf("%-24s %14.2f ns/op\n", "insert_prio + remove_min", heap);
+
+    for (int i = 0; i < ops; i++) {
+        if (strcmp(out[0] + (size_t) i * STRLEN_MAX,
+                   out[1] + (size_t) i * STRLEN_MAX)) {
+            fprintf(stderr, "removal %d differs\n", i);
+            return 1;
+        }
+    }
+    free(out[0]);
+    free(out[1]);
+    free(pool);
+    return 0;
+}
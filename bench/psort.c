@@ -0,0 +1,104 @@
+/* Time the merge sort of q_sort() on 1, 2, 4 and 8 threads, on random and
+ * sorted queues, checking that equal strings keep their order.
+ *
+ * Usage: bench/psort [n]    (default: 10^7)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+/* Room for the random strings, plus the terminator */
+#define STRLEN_MAX 16
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Short strings, so that stability is put to the test */
+static void fill_random(char *buf)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
+    int len = 1 + rand() % 5;
+    for (int i = 0; i < len; i++)
+        buf[i] = charset[rand() % (sizeof(charset) - 1)];
+    buf[len] = '\0';
+}
+
+/* Link the @n elements of @pool on @q, in pool order */
+static void build(queue_t *q, char *pool, size_t stride, int n)
+{
+    memset(q, 0, sizeof(*q));
+    INIT_LIST_HEAD(&q->head);
+    q->size = n;
+    for (int i = 0; i < n; i++)
+        list_add_tail(&((element_t *) (pool + (size_t) i * stride))->list,
+                      &q->head);
+}
+
+/* Sorted, with equal strings in pool order */
+static bool is_stable(struct list_head *head)
+{
+    element_t *e;
+    list_for_each_entry (e, head, list) {
+        if (e->list.next == head)
+            break;
+        element_t *next = list_entry(e->list.next, element_t, list);
+        int cmp = strcmp(e->value, next->value);
+        if (cmp > 0 || (!cmp && e > next))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    size_t stride = (sizeof(element_t) + STRLEN_MAX + 7) & ~(size_t) 7;
+    char *pool = malloc(stride * n);
+    if (!pool) {
+        fprintf(stderr, "Could not allocate %d elements\n", n);
+        return 1;
+    }
+
+    srand(1);
+    for (int i = 0; i < n; i++) {
+        element_t *e = (element_t *) (pool + (size_t) i * stride);
+        e->value = e->data;
+        fill_random(e->value);
+        e->key = q_key(e->value);
+        e->len = strlen(e->value);
+    }
+
+    printf("n = %d\n%-8s %12s %12s %12s\n", n, "threads", "random ms",
+           "sorted ms", "speedup");
+    double base = 0;
+    for (q_sort_threads = 1; q_sort_threads <= 8; q_sort_threads *= 2) {
+        queue_t q;
+        build(&q, pool, stride, n);
+        double t0 = now();
+        q_sort(&q.head, false);
+        double t1 = now();
+        if (!is_stable(&q.head)) {
+            fprintf(stderr, "list is not sorted stably\n");
+            return 1;
+        }
+        q_sort(&q.head, false);
+        double t2 = now();
+        if (q_sort_threads == 1)
+            base = t1 - t0;
+        printf("%-8d %12.2f %12.2f %12.2f\n", q_sort_threads, (t1 - t0) / 1e6,
+               (t2 - t1) / 1e6, base / (t1 - t0));
+    }
+
+    free(pool);
+    return 0;
+}
@@ -0,0 +1,195 @@
+/* Time the queue operations the element indexes change, along with the memory
+ * taken per element and a walk over the keys in queue order, for whichever
+ * index the tree is built with. Compare "make bench" against
+ * "make clean; make INDEX=ring bench" and INDEX=unrolled.
+ *
+ * Half of the elements go in one q_insert_tail() at a time, the other half in
+ * one q_insert_tail_bulk() call, as qtest's "it str n" does with and without
+ * "option bulk 1". Each reordering reports whether it ran on the index or on
+ * the list.
+ *
+ * Usage: bench/qindex [n]    (default: 10^6)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "qindex.h"
+#include "queue.h"
+
+/* Room for the random strings qtest generates, plus the terminator */
+#define STRLEN_MAX 16
+
+/* The first q_delete_mid() after q_reverse() walks to the middle, the others
+ * take constant time: enough calls to spread that walk
+ */
+#define MID_DELETES 100000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_random(char *buf)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
+    int len = 5 + rand() % 5;
+    for (int i = 0; i < len; i++)
+        buf[i] = charset[rand() % (sizeof(charset) - 1)];
+    buf[len] = '\0';
+}
+
+/* Sum the keys of the elements in queue order, through the index when there
+ * is one
+ */
+static uint64_t walk(struct list_head *head)
+{
+    uint64_t sum = 0;
+#if defined(QINDEX_RING)
+    queue_t *q = list_entry(head, queue_t, head);
+    for (size_t i = 0; i < (size_t) q->size; i++)
+        sum += q->ring[(q->first + i) & (q->cap - 1)]->key;
+#elif defined(QINDEX_UNROLLED)
+    queue_t *q = list_entry(head, queue_t, head);
+    struct qchunk *c;
+    list_for_each_entry (c, &q->chunks, link) {
+        for (int i = c->first; i < c->first + c->count; i++)
+            sum += c->key[i];
+    }
+#else
+    element_t *e;
+    list_for_each_entry (e, head, list)
+        sum += e->key;
+#endif
+    return sum;
+}
+
+static void report_walk(const char *op, struct list_head *head)
+{
+    qindex_sync(list_entry(head, queue_t, head));
+    double t0 = now();
+    uint64_t sum = walk(head);
+    double t1 = now();
+    printf("%-14s %12.2f ns/element (checksum %llx)\n", op,
+           (t1 - t0) / q_size(head), (unsigned long long) sum);
+}
+
+static void report_op(const char *op, double t0, double t1, int n)
+{
+    printf("%-14s %12.2f ns/op\n", op, (t1 - t0) / n);
+}
+
+/* Whether the last reordering left the index in sync, which only the index
+ * paths do
+ */
+static const char *path(struct list_head *head)
+{
+#ifdef QINDEX
+    if (list_entry(head, queue_t, head)->index_valid)
+        return "index";
+#endif
+    return "list";
+}
+
+static void report_reorder(const char *op,
+                           double t0,
+                           double t1,
+                           struct list_head *head)
+{
+    printf("%-14s %12.2f ns/element (%s)\n", op,
+           (t1 - t0) / q_size(head), path(head));
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    char *pool = malloc((size_t) n * STRLEN_MAX);
+    if (!pool) {
+        fprintf(stderr, "Could not allocate %d strings\n", n);
+        return 1;
+    }
+
+    /* Count the harness out of what is measured, as far as it goes */
+    set_cautious_mode(false);
+    srand(1);
+    for (int i = 0; i < n; i++)
+        fill_random(pool + (size_t) i * STRLEN_MAX);
+
+#if defined(QINDEX_RING)
+    printf("index: ring, n = %d\n", n);
+#elif defined(QINDEX_UNROLLED)
+    printf("index: unrolled, n = %d\n", n);
+#else
+    printf("index: none, n = %d\n", n);
+#endif
+
+    char **sv = malloc((size_t) (n - n / 2) * sizeof(*sv));
+    if (!sv) {
+        fprintf(stderr, "Could not allocate %d strings\n", n);
+        return 1;
+    }
+    for (int i = n / 2; i < n; i++)
+        sv[i - n / 2] = pool + (size_t) i * STRLEN_MAX;
+
+    size_t bytes = allocation_bytes();
+    struct list_head *q = q_new();
+    double t0 = now();
+    for (int i = 0; i < n / 2; i++)
+        q_insert_tail(q, pool + (size_t) i * STRLEN_MAX);
+    double t1 = now();
+    report_op("insert_tail", t0, t1, n / 2);
+    t0 = now();
+    q_insert_tail_bulk(q, sv, n - n / 2);
+    t1 = now();
+    report_op("insert_bulk", t0, t1, n - n / 2);
+    printf("%-14s %12.2f bytes/element, harness blocks included\n", "memory",
+           (double) (allocation_bytes() - bytes) / n);
+    report_walk("walk", q);
+
+    t0 = now();
+    q_sort(q, false);
+    t1 = now();
+    report_reorder("sort", t0, t1, q);
+    report_walk("walk sorted", q);
+
+    /* The middle deletion leaves the index stale, for reverse to rebuild */
+    q_delete_mid(q);
+    t0 = now();
+    q_reverse(q);
+    t1 = now();
+    report_reorder("reverse", t0, t1, q);
+
+    t0 = now();
+    q_swap(q);
+    t1 = now();
+    report_reorder("swap", t0, t1, q);
+
+    t0 = now();
+    q_reverseK(q, 3);
+    t1 = now();
+    report_reorder("reverseK 3", t0, t1, q);
+
+    t0 = now();
+    for (int i = 0; i < MID_DELETES && i < n; i++)
+        q_delete_mid(q);
+    t1 = now();
+    report_op("delete_mid", t0, t1, MID_DELETES);
+
+    int left = q_size(q);
+    t0 = now();
+    element_t *e;
+    while ((e = q_remove_head(q, NULL, 0)))
+        q_release_element(e);
+    t1 = now();
+    report_op("remove_head", t0, t1, left);
+
+    q_free(q);
+    free(sv);
+    free(pool);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/* Compare the in-place q_reverse()/q_reverseK() against the former versions,
+ * which moved every node and spliced each group through a temporary list.
+ *
+ * Usage: bench/reverse [n]    (default: 10^6)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+/* Each configuration is timed this many times, the best run is reported */
+#define ROUNDS 5
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* The former q_reverse(): one list_move() per node */
+static void move_reverse(struct list_head *head)
+{
+    struct list_head *current, *safe;
+    list_for_each_safe (current, safe, head)
+        list_move(current, head);
+}
+
+/* The former q_reverseK(): cut each group, reverse it and splice it back */
+static void splice_reverse_k(struct list_head *head, int k)
+{
+    size_t cnt = 0;
+    struct list_head *curr = NULL, *safe = NULL, *start = head;
+    list_for_each_safe (curr, safe, head) {
+        if (++cnt == k) {
+            LIST_HEAD(tmp);
+            cnt = 0;
+            list_cut_position(&tmp, start, curr);
+            move_reverse(&tmp);
+            list_splice(&tmp, start);
+            start = safe->prev;
+        }
+    }
+}
+
+/* Element i holds i, so the expected order can be recomputed */
+static bool check(struct list_head *head, int n, int k)
+{
+    element_t *e;
+    int i = 0;
+    list_for_each_entry (e, head, list) {
+        int group = i - i % k;
+        int want = group + k <= n ? group + k - 1 - i % k : i;
+        if ((int) e->key != want)
+            return false;
+        i++;
+    }
+    return i == n;
+}
+
+static void build(queue_t *q, element_t *pool, int n)
+{
+    /* Leave no index state behind, see qindex.h */
+    memset(q, 0, sizeof(*q));
+    INIT_LIST_HEAD(&q->head);
+    q->size = n;
+    for (int i = 0; i < n; i++) {
+        pool[i].key = i;
+        list_add_tail(&pool[i].list, &q->head);
+    }
+}
+
+/* Nanoseconds per element of reversing @n elements @k at a time, where
+ * k == n stands for a full reverse
+ */
+static double run(bool old, element_t *pool, int n, int k)
+{
+    double best = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        queue_t q;
+        build(&q, pool, n);
+        double t0 = now();
+        if (k == n)
+            old ? move_reverse(&q.head) : q_reverse(&q.head);
+        else
+            old ? splice_reverse_k(&q.head, k) : q_reverseK(&q.head, k);
+        double t = (now() - t0) / n;
+        if (!check(&q.head, n, k)) {
+            fprintf(stderr, "wrong order for k = %d\n", k);
+            exit(1);
+        }
+        if (!r || t < best)
+            best = t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    static const int ks[] = {2, 16, 1024};
+    element_t *pool = malloc(sizeof(element_t) * n);
+    if (!pool) {
+        fprintf(stderr, "Could not allocate %d elements\n", n);
+        return 1;
+    }
+
+    printf("n = %d\n%-9s %16s %16s\n", n, "k", "splice ns/elem",
+           "in-place ns/elem");
+    for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+        double old = run(true, pool, n, ks[i]);
+        double new = run(false, pool, n, ks[i]);
+        printf("%-9d %16.2f %16.2f\n", ks[i], old, new);
+    }
+    double old = run(true, pool, n, n);
+    double new = run(false, pool, n, n);
+    printf("%-9s %16.2f %16.2f\n", "reverse", old, new);
+
+    free(pool);
+    return 0;
+}
@@ -0,0 +1,173 @@
+/* Compare the q_sort() engines against the recursive top-down merge sort it
+ * formerly used, on random, sorted and reverse-sorted queues.
+ *
+ * Usage: bench/sort [max_n]    (default: 10^7)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+/* Room for the random strings qtest generates, plus the terminator */
+#define STRLEN_MAX 16
+
+typedef enum { INPUT_RANDOM, INPUT_SORTED, INPUT_REVERSED } input_t;
+static const char *input_names[] = {"random", "sorted", "reversed"};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_element(void *priv,
+                       const struct list_head *a,
+                       const struct list_head *b)
+{
+    return strcmp(list_entry(a, element_t, list)->value,
+                  list_entry(b, element_t, list)->value);
+}
+
+/* The former q_sort(): split at the middle with fast/slow pointers, recurse
+ * and merge
+ */
+static void merge_two(struct list_head *first, struct list_head *second)
+{
+    LIST_HEAD(tmp);
+    while (!list_empty(first) && !list_empty(second)) {
+        element_t *a = list_first_entry(first, element_t, list);
+        element_t *b = list_first_entry(second, element_t, list);
+        element_t *min = strcmp(a->value, b->value) < 0 ? a : b;
+        list_move_tail(&min->list, &tmp);
+    }
+    list_splice_tail_init(first, &tmp);
+    list_splice_tail_init(second, &tmp);
+    list_splice(&tmp, first);
+}
+
+static void top_down_sort(struct list_head *head)
+{
+    if (list_empty(head) || list_is_singular(head))
+        return;
+    struct list_head *slow = head;
+    const struct list_head *fast = head->next;
+    for (; fast != head && fast->next != head; fast = fast->next->next)
+        slow = slow->next;
+    struct list_head left;
+    list_cut_position(&left, head, slow);
+    top_down_sort(&left);
+    top_down_sort(head);
+    merge_two(head, &left);
+}
+
+static void bottom_up_sort(struct list_head *head)
+{
+    q_sort_mode = SORT_MERGE;
+    q_sort(head, false);
+}
+
+static void natural_sort(struct list_head *head)
+{
+    q_sort_mode = SORT_TIMSORT;
+    q_sort(head, false);
+}
+
+static void radix_sort(struct list_head *head)
+{
+    q_sort_mode = SORT_RADIX;
+    q_sort(head, false);
+}
+
+static void fill_random(char *buf)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
+    int len = 5 + rand() % 5;
+    for (int i = 0; i < len; i++)
+        buf[i] = charset[rand() % (sizeof(charset) - 1)];
+    buf[len] = '\0';
+}
+
+/* Link the first @n elements of @pool on @q in the order given by @input */
+static void build(queue_t *q, char *pool, size_t stride, int n, input_t input)
+{
+    struct list_head *head = &q->head;
+
+    /* Leave no index state behind, see qindex.h */
+    memset(q, 0, sizeof(*q));
+    INIT_LIST_HEAD(head);
+    q->size = n;
+    for (int i = 0; i < n; i++) {
+        element_t *e = (element_t *) (pool + (size_t) i * stride);
+        e->value = e->data;
+        if (input == INPUT_RANDOM)
+            fill_random(e->value);
+        else
+            snprintf(e->value, STRLEN_MAX, "%09d",
+                     input == INPUT_SORTED ? i : n - i);
+        e->key = q_key(e->value);
+        e->len = strlen(e->value);
+        list_add_tail(&e->list, head);
+    }
+}
+
+static bool is_sorted(struct list_head *head)
+{
+    struct list_head *node;
+    list_for_each (node, head) {
+        if (node->next != head && cmp_element(NULL, node, node->next) > 0)
+            return false;
+    }
+    return true;
+}
+
+static double run(void (*sort)(struct list_head *),
+                  char *pool,
+                  size_t stride,
+                  int n,
+                  input_t input)
+{
+    queue_t q;
+    srand(n);
+    build(&q, pool, stride, n, input);
+    double t0 = now();
+    sort(&q.head);
+    double t1 = now();
+    if (!is_sorted(&q.head)) {
+        fprintf(stderr, "list is not sorted\n");
+        exit(1);
+    }
+    return (t1 - t0) / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_n = argc > 1 ? atoi(argv[1]) : 10000000;
+    size_t stride = (sizeof(element_t) + STRLEN_MAX + 7) & ~(size_t) 7;
+    char *pool = malloc(stride * max_n);
+    if (!pool) {
+        fprintf(stderr, "Could not allocate %d elements\n", max_n);
+        return 1;
+    }
+
+    printf("%-9s %9s %12s %12s %12s %12s\n", "input", "n", "top-down ms",
+           "merge ms", "timsort ms", "radix ms");
+    for (int n = 10000; n <= max_n; n *= 10) {
+        for (input_t in = INPUT_RANDOM; in <= INPUT_REVERSED; in++) {
+            double td = run(top_down_sort, pool, stride, n, in);
+            double bu = run(bottom_up_sort, pool, stride, n, in);
+            double ts = run(natural_sort, pool, stride, n, in);
+            double rs = run(radix_sort, pool, stride, n, in);
+            printf("%-9s %9d %12.2f %12.2f %12.2f %12.2f\n", input_names[in],
+                   n, td, bu, ts, rs);
+        }
+    }
+
+    free(pool);
+    return 0;
+}
@@ -0,0 +1,176 @@
+/* Time the comparison of long strings sharing a long prefix, byte by byte
+ * with strcmp() against simd_memcmp() on their known lengths, then sorting
+ * and removing such strings the way the queue used to and does now.
+ * Build with "make AVX2=1 bench" to compare 32 bytes at a time.
+ *
+ * The strings take about 650 bytes each on average: with large n, memory
+ * rather than the comparison sets the pace.
+ *
+ * Usage: bench/strcmp [n]    (default: 10^4)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INTERNAL 1
+#include "harness.h"
+#include "queue.h"
+
+/* Strings run from STRLEN_MIN to STRLEN_MAX bytes, the first PREFIX_LEN
+ * of which all of them share
+ */
+#define STRLEN_MIN 256
+#define STRLEN_MAX 1024
+#define PREFIX_LEN 240
+
+/* Size of the buffer strings are removed into, as qtest passes */
+#define BUFSIZE 1024
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_random(char *buf)
+{
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
+    int len = STRLEN_MIN + rand() % (STRLEN_MAX - STRLEN_MIN + 1);
+    memset(buf, 'k', PREFIX_LEN);
+    for (int i = PREFIX_LEN; i < len; i++)
+        buf[i] = charset[rand() % (sizeof(charset) - 1)];
+    buf[len] = '\0';
+}
+
+static int cmp_strcmp(void *priv,
+                      const struct list_head *a,
+                      const struct list_head *b)
+{
+    return strcmp(list_entry(a, element_t, list)->value,
+                  list_entry(b, element_t, list)->value);
+}
+
+static int cmp_element(void *priv,
+                       const struct list_head *a,
+                       const struct list_head *b)
+{
+    return q_element_cmp(list_entry(a, element_t, list),
+                         list_entry(b, element_t, list));
+}
+
+static inline int sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+/* Link every element of @pool on @head, in pool order */
+static void build(struct list_head *head, char *pool, size_t stride, int n)
+{
+    INIT_LIST_HEAD(head);
+    for (int i = 0; i < n; i++)
+        list_add_tail(&((element_t *) (pool + (size_t) i * stride))->list,
+                      head);
+}
+
+static double sort(char *pool, size_t stride, int n, list_cmp_func_t cmp)
+{
+    struct list_head head;
+    build(&head, pool, stride, n);
+    double t0 = now();
+    list_sort(NULL, &head, cmp);
+    double t1 = now();
+    return (t1 - t0) / n;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 10000;
+    size_t stride = (sizeof(element_t) + STRLEN_MAX + 1 + 7) & ~(size_t) 7;
+    char *pool = malloc(stride * n);
+    char *buf = malloc(BUFSIZE);
+    if (!pool || !buf) {
+        fprintf(stderr, "Could not allocate %d elements\n", n);
+        return 1;
+    }
+
+    srand(1);
+    for (int i = 0; i < n; i++) {
+        element_t *e = (element_t *) (pool + (size_t) i * stride);
+        e->value = e->data;
+        fill_random(e->value);
+        e->key = q_key(e->value);
+        e->len = strlen(e->value);
+    }
+#if defined(__AVX2__)
+    printf("n = %d, kernel: AVX2\n", n);
+#elif defined(__SSE2__)
+    printf("n = %d, kernel: SSE2\n", n);
+#else
+    printf("n = %d, kernel: scalar\n", n);
+#endif
+
+    /* Bring the strings into cache as far as they fit, for both to start
+     * alike
+     */
+    volatile size_t warm = 0;
+    for (int i = 0; i < n; i++)
+        warm += strlen(((element_t *) (pool + (size_t) i * stride))->value);
+
+    /* Every element against the next one, then against itself */
+    long sum[2] = {0, 0};
+    double t[3];
+    for (int k = 0; k < 2; k++) {
+        t[0] = now();
+        for (int i = 0; i < n; i++) {
+            element_t *a = (element_t *) (pool + (size_t) i * stride);
+            element_t *b = (element_t *) (pool + (size_t) ((i + k) % n) *
+                                          stride);
+            sum[0] += sign(strcmp(a->value, b->value));
+        }
+        t[1] = now();
+        for (int i = 0; i < n; i++) {
+            element_t *a = (element_t *) (pool + (size_t) i * stride);
+            element_t *b = (element_t *) (pool + (size_t) ((i + k) % n) *
+                                          stride);
+            size_t len = a->len < b->len ? a->len : b->len;
+            sum[1] += sign(simd_memcmp(a->value, b->value, len + 1));
+        }
+        t[2] = now();
+        printf("%-16s %12.2f ns/op strcmp %12.2f ns/op kernel\n",
+               k ? "compare equal" : "compare", (t[1] - t[0]) / n,
+               (t[2] - t[1]) / n);
+    }
+    if (sum[0] != sum[1]) {
+        fprintf(stderr, "kernel disagrees with strcmp\n");
+        return 1;
+    }
+
+    printf("%-16s %12.2f ns/elem strcmp %11.2f ns/elem kernel\n", "sort",
+           sort(pool, stride, n, cmp_strcmp),
+           sort(pool, stride, n, cmp_element));
+
+    /* Copy out as q_remove_head() formerly did, then as it does now */
+    t[0] = now();
+    for (int i = 0; i < n; i++) {
+        const element_t *e = (element_t *) (pool + (size_t) i * stride);
+        strncpy(buf, e->value, BUFSIZE);
+        buf[BUFSIZE - 1] = '\0';
+    }
+    t[1] = now();
+    for (int i = 0; i < n; i++) {
+        const element_t *e = (element_t *) (pool + (size_t) i * stride);
+        size_t len = e->len < BUFSIZE - 1 ? e->len : BUFSIZE - 1;
+        memcpy(buf, e->value, len);
+        buf[len] = '\0';
+    }
+    t[2] = now();
+    printf("%-16s %12.2f ns/op strncpy %11.2f ns/op memcpy\n", "copy out",
+           (t[1] - t[0]) / n, (t[2] - t[1]) / n);
+
+    free(buf);
+    free(pool);
+    return 0;
+}
@@ -73,7 +73,8 @@ bool measure(int64_t *before_ticks,
              int mode)
 {
     assert(mode == DUT(insert_head) || mode == DUT(insert_tail) ||
-           mode == DUT(remove_head) || mode == DUT(remove_tail));
+           mode == DUT(remove_head) || mode == DUT(remove_tail) ||
+           mode == DUT(size));
 
     switch (mode) {
     case DUT(insert_head):
@@ -146,17 +147,22 @@ bool measure(int64_t *before_ticks,
                 return false;
         }
         break;
-    default:
+    case DUT(size):
         for (size_t i = DROP_SIZE; i < N_MEASURES - DROP_SIZE; i++) {
+            int n = *(uint16_t *) (input_data + i * CHUNK_SIZE) % 10000;
             dut_new();
-            dut_insert_head(
-                get_random_string(),
-                *(uint16_t *) (input_data + i * CHUNK_SIZE) % 10000);
+            dut_insert_head(get_random_string(), n);
             before_ticks[i] = cpucycles();
             dut_size(1);
             after_ticks[i] = cpucycles();
+            int size = q_size(l);
             dut_free();
+            if (size != n)
+                return false;
         }
+        break;
+    default:
+        break;
     }
     return true;
 }
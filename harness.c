@@ -43,6 +43,7 @@ typedef struct __block_element {
 
 static block_element_t *allocated = NULL;
 static size_t allocated_count = 0;
+static size_t allocated_bytes = 0;
 
 /* Percent probability of malloc failure */
 int fail_probability = 0;
@@ -165,6 +166,7 @@ static void *alloc(alloc_t alloc_type, size_t size)
         allocated->prev = new_block;
     allocated = new_block;
     allocated_count++;
+    allocated_bytes += size + sizeof(block_element_t) + sizeof(size_t);
 
     return p;
 }
@@ -220,6 +222,8 @@ void test_free(void *p)
     if (bn)
         bn->prev = bp;
 
+    allocated_bytes -=
+        b->payload_size + sizeof(block_element_t) + sizeof(size_t);
     free(b);
     allocated_count--;
 }
@@ -240,6 +244,11 @@ size_t allocation_check()
     return allocated_count;
 }
 
+size_t allocation_bytes()
+{
+    return allocated_bytes;
+}
+
 /* Implementation of functions for testing */
 
 /* Set/unset cautious mode.
@@ -21,6 +21,11 @@ char *test_strdup(const char *s);
 /* Report number of allocated blocks */
 size_t allocation_check();
 
+/* Report number of bytes held by allocated blocks, including the header and
+ * footer the harness wraps around each of them
+ */
+size_t allocation_bytes();
+
 /* Probability of malloc failing, expressed as percent */
 extern int fail_probability;
 
@@ -0,0 +1,84 @@
+/* Intern pool of queue strings, see intern.h */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+
+/* Chained hash table of the pool, grown to keep at most one string per bucket
+ * on average and released along with its last string
+ */
+static struct intern **bucket;
+static size_t nbuckets, count;
+
+/* Buckets allocated for the first string */
+#define INTERN_MIN 64
+
+/* Rehash into twice as many buckets; failing only makes chains longer */
+static void intern_grow(void)
+{
+    size_t n = nbuckets ? 2 * nbuckets : INTERN_MIN;
+    struct intern **b = calloc(n, sizeof(*b));
+    if (!b)
+        return;
+    for (size_t i = 0; i < nbuckets; i++) {
+        struct intern *e, *next;
+        for (e = bucket[i]; e; e = next) {
+            next = e->next;
+            e->next = b[e->hash & (n - 1)];
+            b[e->hash & (n - 1)] = e;
+        }
+    }
+    free(bucket);
+    bucket = b;
+    nbuckets = n;
+}
+
+char *intern_get(const char *s, size_t refs)
+{
+    uint32_t hash = q_hash(s);
+    if (nbuckets) {
+        struct intern *e = bucket[hash & (nbuckets - 1)];
+        for (; e; e = e->next) {
+            if (e->hash == hash && !strcmp(e->str, s)) {
+                e->refs += refs;
+                return e->str;
+            }
+        }
+    }
+
+    if (count >= nbuckets)
+        intern_grow();
+    if (!nbuckets)
+        return NULL;
+    size_t len = strlen(s) + 1;
+    struct intern *e = malloc(sizeof(*e) + len);
+    if (!e)
+        return NULL;
+    memcpy(e->str, s, len);
+    e->refs = refs;
+    e->hash = hash;
+    e->next = bucket[hash & (nbuckets - 1)];
+    bucket[hash & (nbuckets - 1)] = e;
+    count++;
+    return e->str;
+}
+
+void intern_put(char *s)
+{
+    struct intern *e = intern_of(s);
+    if (--e->refs)
+        return;
+
+    struct intern **p = &bucket[e->hash & (nbuckets - 1)];
+    while (*p != e)
+        p = &(*p)->next;
+    *p = e->next;
+    free(e);
+
+    if (!--count) {
+        free(bucket);
+        bucket = NULL;
+        nbuckets = 0;
+    }
+}
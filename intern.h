@@ -0,0 +1,45 @@
+#ifndef LAB0_INTERN_H
+#define LAB0_INTERN_H
+
+/* Pool of refcounted immutable strings, shared by the elements inserted with
+ * equal strings while q_intern_strings is set. The string of such an element
+ * lives in the pool rather than inline after it, see element_t, and goes away
+ * with the last element referring to it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * struct intern - String of the pool
+ * @next: next string in the same bucket of the hash table
+ * @refs: the number of references held on the string
+ * @hash: q_hash() of the string
+ * @str: the string
+ */
+struct intern {
+    struct intern *next;
+    size_t refs;
+    uint32_t hash;
+    char str[];
+};
+
+/* The pool entry holding the interned string @s */
+static inline struct intern *intern_of(const char *s)
+{
+    return (struct intern *) (s - offsetof(struct intern, str));
+}
+
+/**
+ * intern_get() - Take references on the pooled copy of a string
+ * @s: the string, added to the pool if it is not there yet
+ * @refs: the number of references to take
+ *
+ * Return: the pooled copy, %NULL for allocation failed
+ */
+char *intern_get(const char *s, size_t refs);
+
+/* Drop a reference on the interned string @s, releasing it with the last */
+void intern_put(char *s);
+
+#endif /* LAB0_INTERN_H */
@@ -452,6 +452,160 @@ static inline void list_move_tail(struct list_head *node,
         safe = list_entry(safe->member.next, typeof(*entry), member))
 #endif
 
+/**
+ * list_cmp_func_t - Comparison callback used by list_sort()
+ *
+ * Return: a negative value if the first node sorts before the second one, a
+ * positive value if it sorts after, zero if the two nodes are equivalent.
+ */
+typedef int (*list_cmp_func_t)(void *,
+                               const struct list_head *,
+                               const struct list_head *);
+
+/* Merge two null-terminated singly-linked lists, @a taking priority on ties */
+static inline struct list_head *__list_merge(void *priv,
+                                             list_cmp_func_t cmp,
+                                             struct list_head *a,
+                                             struct list_head *b)
+{
+    struct list_head *head = NULL, **tail = &head;
+
+    for (;;) {
+        if (cmp(priv, a, b) <= 0) {
+            *tail = a;
+            tail = &a->next;
+            a = a->next;
+            if (!a) {
+                *tail = b;
+                break;
+            }
+        } else {
+            *tail = b;
+            tail = &b->next;
+            b = b->next;
+            if (!b) {
+                *tail = a;
+                break;
+            }
+        }
+    }
+    return head;
+}
+
+/* Merge the last two sublists into @head, restoring the prev pointers and the
+ * circular structure on the way
+ */
+static inline void __list_merge_final(void *priv,
+                                      list_cmp_func_t cmp,
+                                      struct list_head *head,
+                                      struct list_head *a,
+                                      struct list_head *b)
+{
+    struct list_head *tail = head;
+
+    for (;;) {
+        if (cmp(priv, a, b) <= 0) {
+            tail->next = a;
+            a->prev = tail;
+            tail = a;
+            a = a->next;
+            if (!a)
+                break;
+        } else {
+            tail->next = b;
+            b->prev = tail;
+            tail = b;
+            b = b->next;
+            if (!b) {
+                b = a;
+                break;
+            }
+        }
+    }
+
+    /* Splice the rest of the remaining sublist */
+    tail->next = b;
+    do {
+        b->prev = tail;
+        tail = b;
+        b = b->next;
+    } while (b);
+
+    tail->next = head;
+    head->prev = tail;
+}
+
+/**
+ * list_sort() - Sort a list with a stable, bottom-up merge sort
+ * @priv: private data passed through to @cmp
+ * @head: pointer to the head of the list
+ * @cmp: comparison function
+ *
+ * Nodes are visited once, from first to last. Each one is pushed on a stack of
+ * pending sublists, chained through their @prev pointers, whose sizes are
+ * powers of two. Two pending sublists of size 2^k are merged as soon as 2^k
+ * further nodes have been visited, which keeps merges balanced (at worst 2:1)
+ * without knowing the length of the list in advance. The remaining sublists
+ * are merged once the input is exhausted.
+ *
+ * Nodes comparing equal keep their relative order, no memory is allocated and
+ * no recursion is involved. The algorithm follows lib/list_sort.c from the
+ * Linux kernel.
+ */
+static inline void list_sort(void *priv,
+                             struct list_head *head,
+                             list_cmp_func_t cmp)
+{
+    struct list_head *list = head->next, *pending = NULL;
+    size_t count = 0; /* Count of pending sublists */
+
+    if (list == head->prev) /* Zero or one elements */
+        return;
+
+    /* Convert to a null-terminated singly-linked list */
+    head->prev->next = NULL;
+
+    do {
+        size_t bits;
+        struct list_head **tail = &pending;
+
+        /* Find the least-significant clear bit in count */
+        for (bits = count; bits & 1; bits >>= 1)
+            tail = &(*tail)->prev;
+        /* Do the indicated merge, unless count is 2^k - 1 */
+        if (bits) {
+            struct list_head *a = *tail, *b = a->prev;
+
+            a = __list_merge(priv, cmp, b, a);
+            /* Install the merged result in place of the inputs */
+            a->prev = b->prev;
+            *tail = a;
+        }
+
+        /* Move one element from input list to pending */
+        list->prev = pending;
+        pending = list;
+        list = list->next;
+        pending->next = NULL;
+        count++;
+    } while (list);
+
+    /* All nodes are pending: merge them from the smallest sublist up */
+    list = pending;
+    pending = pending->prev;
+    for (;;) {
+        struct list_head *next = pending->prev;
+
+        if (!next)
+            break;
+        list = __list_merge(priv, cmp, pending, list);
+        pending = next;
+    }
+
+    /* The final merge, rebuilding prev links */
+    __list_merge_final(priv, cmp, head, pending, list);
+}
+
 #undef __LIST_HAVE_TYPEOF
 
 #ifdef __cplusplus
@@ -0,0 +1,201 @@
+/* Lock-free MPMC queue with hazard pointers, see mpmc.h */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The harness is not thread-safe: use the allocator of the C library */
+#define INTERNAL 1
+#include "harness.h"
+#include "mpmc.h"
+
+#define CACHE_LINE 64
+
+/* Retired nodes a thread holds before scanning the hazard pointers: twice
+ * as many as there can be hazard pointers, so that each scan frees at least
+ * half of them
+ */
+#define MPMC_RETIRE_MAX (2 * 2 * MPMC_MAX_THREADS)
+
+struct mpmc_node {
+    _Atomic(struct mpmc_node *) next;
+    element_t *e;
+};
+
+/* Per-thread state, on a cache line of its own */
+struct mpmc_slot {
+    _Alignas(CACHE_LINE) _Atomic(struct mpmc_node *) hp[2];
+    atomic_bool used;
+    int nretired;
+    struct mpmc_node *retired[MPMC_RETIRE_MAX];
+};
+
+struct mpmc {
+    _Alignas(CACHE_LINE) _Atomic(struct mpmc_node *) head;
+    _Alignas(CACHE_LINE) _Atomic(struct mpmc_node *) tail;
+    struct mpmc_slot slot[MPMC_MAX_THREADS];
+};
+
+mpmc_t *mpmc_new(void)
+{
+    mpmc_t *q = aligned_alloc(CACHE_LINE, sizeof(*q));
+    struct mpmc_node *dummy = malloc(sizeof(*dummy));
+    if (!q || !dummy) {
+        free(q);
+        free(dummy);
+        return NULL;
+    }
+
+    atomic_init(&dummy->next, NULL);
+    atomic_init(&q->head, dummy);
+    atomic_init(&q->tail, dummy);
+    for (int i = 0; i < MPMC_MAX_THREADS; i++) {
+        atomic_init(&q->slot[i].hp[0], NULL);
+        atomic_init(&q->slot[i].hp[1], NULL);
+        atomic_init(&q->slot[i].used, false);
+        q->slot[i].nretired = 0;
+    }
+    return q;
+}
+
+void mpmc_free(mpmc_t *q)
+{
+    if (!q)
+        return;
+
+    struct mpmc_node *node = atomic_load(&q->head);
+    while (node) {
+        struct mpmc_node *next = atomic_load(&node->next);
+        free(node);
+        node = next;
+    }
+    for (int i = 0; i < MPMC_MAX_THREADS; i++) {
+        for (int j = 0; j < q->slot[i].nretired; j++)
+            free(q->slot[i].retired[j]);
+    }
+    free(q);
+}
+
+int mpmc_attach(mpmc_t *q)
+{
+    for (int i = 0; i < MPMC_MAX_THREADS; i++) {
+        bool used = false;
+        if (atomic_compare_exchange_strong(&q->slot[i].used, &used, true))
+            return i;
+    }
+    return -1;
+}
+
+/* Retired nodes stay with the slot, for its next owner to free */
+void mpmc_detach(mpmc_t *q, int slot)
+{
+    atomic_store(&q->slot[slot].hp[0], NULL);
+    atomic_store(&q->slot[slot].hp[1], NULL);
+    atomic_store(&q->slot[slot].used, false);
+}
+
+/* Publish @*src in hazard pointer @hp and return it, once it is known not to
+ * have changed in between, so that it was not retired before being protected
+ */
+static struct mpmc_node *protect(_Atomic(struct mpmc_node *) *hp,
+                                 _Atomic(struct mpmc_node *) *src)
+{
+    struct mpmc_node *node = atomic_load(src), *again;
+    for (;; node = again) {
+        atomic_store(hp, node);
+        again = atomic_load(src);
+        if (again == node)
+            return node;
+    }
+}
+
+/* Free the retired nodes of @s no hazard pointer refers to */
+static void scan(mpmc_t *q, struct mpmc_slot *s)
+{
+    struct mpmc_node *hazards[2 * MPMC_MAX_THREADS];
+    int nhazards = 0;
+    for (int i = 0; i < MPMC_MAX_THREADS; i++) {
+        for (int j = 0; j < 2; j++) {
+            struct mpmc_node *node = atomic_load(&q->slot[i].hp[j]);
+            if (node)
+                hazards[nhazards++] = node;
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < s->nretired; i++) {
+        struct mpmc_node *node = s->retired[i];
+        bool hazardous = false;
+        for (int j = 0; j < nhazards && !hazardous; j++)
+            hazardous = hazards[j] == node;
+        if (hazardous)
+            s->retired[kept++] = node;
+        else
+            free(node);
+    }
+    s->nretired = kept;
+}
+
+bool mpmc_enqueue(mpmc_t *q, int slot, element_t *e)
+{
+    struct mpmc_node *node = malloc(sizeof(*node));
+    if (!node)
+        return false;
+    node->e = e;
+    atomic_init(&node->next, NULL);
+
+    struct mpmc_slot *s = &q->slot[slot];
+    for (;;) {
+        struct mpmc_node *tail = protect(&s->hp[0], &q->tail);
+        struct mpmc_node *next = atomic_load(&tail->next);
+        if (tail != atomic_load(&q->tail))
+            continue;
+        if (next) {
+            /* Help the enqueue in progress swing the tail */
+            atomic_compare_exchange_weak(&q->tail, &tail, next);
+            continue;
+        }
+        if (atomic_compare_exchange_weak(&tail->next, &next, node)) {
+            atomic_compare_exchange_strong(&q->tail, &tail, node);
+            break;
+        }
+    }
+    atomic_store(&s->hp[0], NULL);
+    return true;
+}
+
+element_t *mpmc_dequeue(mpmc_t *q, int slot)
+{
+    struct mpmc_slot *s = &q->slot[slot];
+    struct mpmc_node *head;
+    element_t *e;
+
+    for (;;) {
+        head = protect(&s->hp[0], &q->head);
+        struct mpmc_node *tail = atomic_load(&q->tail);
+        struct mpmc_node *next = protect(&s->hp[1], &head->next);
+        if (head != atomic_load(&q->head))
+            continue;
+        if (!next) {
+            e = NULL;
+            break;
+        }
+        if (head == tail) {
+            atomic_compare_exchange_weak(&q->tail, &tail, next);
+            continue;
+        }
+        /* The next node becomes the dummy, its element is ours */
+        e = next->e;
+        if (atomic_compare_exchange_weak(&q->head, &head, next))
+            break;
+    }
+    atomic_store(&s->hp[0], NULL);
+    atomic_store(&s->hp[1], NULL);
+
+    if (e) {
+        s->retired[s->nretired++] = head;
+        if (s->nretired == MPMC_RETIRE_MAX)
+            scan(q, s);
+    }
+    return e;
+}
@@ -0,0 +1,69 @@
+#ifndef LAB0_MPMC_H
+#define LAB0_MPMC_H
+
+/* Lock-free multi-producer/multi-consumer queue of elements, after Michael
+ * and Scott, "Simple, Fast, and Practical Non-Blocking and Blocking
+ * Concurrent Queue Algorithms" (PODC 1996).
+ *
+ * Unlike the queue of queue.h, any number of threads may enqueue and dequeue
+ * at once. Elements are not linked through their list member but carried by
+ * nodes of a singly-linked list, which always starts with a dummy node. A
+ * node dequeued by one thread may still be read by another, so nodes are
+ * reclaimed through hazard pointers (Michael, "Hazard Pointers: Safe Memory
+ * Reclamation for Lock-Free Objects", IEEE TPDS 2004): each thread publishes
+ * the nodes it is about to read, and retired nodes are only freed once no
+ * hazard pointer refers to them.
+ *
+ * Memory comes from the C library, not from the harness, which is not
+ * thread-safe.
+ */
+
+#include <stdbool.h>
+
+#include "queue.h"
+
+/* Most threads attached to a queue at once */
+#define MPMC_MAX_THREADS 64
+
+typedef struct mpmc mpmc_t;
+
+/* Create an empty queue, %NULL for allocation failed */
+mpmc_t *mpmc_new(void);
+
+/* Free the queue, no effect if @q is NULL. Elements still queued are left
+ * to their owner, and no thread may be attached any longer.
+ */
+void mpmc_free(mpmc_t *q);
+
+/**
+ * mpmc_attach() - Register the calling thread with the queue
+ * @q: the queue
+ *
+ * Return: the slot of the thread, to pass to the other operations, or -1 if
+ * MPMC_MAX_THREADS threads are attached already
+ */
+int mpmc_attach(mpmc_t *q);
+
+/* Release the slot of a thread done with the queue */
+void mpmc_detach(mpmc_t *q, int slot);
+
+/**
+ * mpmc_enqueue() - Append an element at the tail of the queue
+ * @q: the queue
+ * @slot: slot of the calling thread
+ * @e: the element
+ *
+ * Return: true for success, false for allocation failed
+ */
+bool mpmc_enqueue(mpmc_t *q, int slot, element_t *e);
+
+/**
+ * mpmc_dequeue() - Take the element at the head of the queue
+ * @q: the queue
+ * @slot: slot of the calling thread
+ *
+ * Return: the element, %NULL if the queue is empty
+ */
+element_t *mpmc_dequeue(mpmc_t *q, int slot);
+
+#endif /* LAB0_MPMC_H */
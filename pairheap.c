@@ -0,0 +1,164 @@
+/* Pairing heap over the elements of a queue, see pairheap.h */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pairheap.h"
+
+/* Nodes of the smallest array */
+#define HEAP_MIN 64
+
+/* Node of element @e. @child is the first of its children, which are linked
+ * through @next; a node on the free list links to the next one through
+ * @next as well. -1 stands for none.
+ */
+struct heapnode {
+    element_t *e;
+    int child, next;
+};
+
+struct pairheap {
+    struct heapnode *node;
+    int cap, used; /* nodes allocated, nodes ever handed out */
+    int root, free;
+    bool max;
+};
+
+/* Whether node @a belongs above node @b */
+static inline bool heap_before(const struct pairheap *h, int a, int b)
+{
+    int cmp = q_element_cmp(h->node[a].e, h->node[b].e);
+    return h->max ? cmp > 0 : cmp < 0;
+}
+
+/* Meld two heaps, either of which may be -1, and return the root */
+static int heap_meld(struct pairheap *h, int a, int b)
+{
+    if (a < 0)
+        return b;
+    if (b < 0)
+        return a;
+    if (heap_before(h, b, a)) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    h->node[b].next = h->node[a].child;
+    h->node[a].child = b;
+    return a;
+}
+
+/* Make room for @cap nodes, keeping the first @h->used */
+static bool heap_reserve(struct pairheap *h, int cap)
+{
+    if (cap <= h->cap)
+        return true;
+
+    int size = h->cap ? h->cap : HEAP_MIN;
+    while (size < cap)
+        size *= 2;
+    struct heapnode *node = malloc(size * sizeof(*node));
+    if (!node)
+        return false;
+    if (h->used)
+        memcpy(node, h->node, h->used * sizeof(*node));
+    free(h->node);
+    h->node = node;
+    h->cap = size;
+    return true;
+}
+
+/* Hand out a node for @e, not linked to any other */
+static int heap_node_new(struct pairheap *h, element_t *e)
+{
+    int i = h->free;
+    if (i >= 0)
+        h->free = h->node[i].next;
+    else
+        i = h->used++;
+    h->node[i] = (struct heapnode){e, -1, -1};
+    return i;
+}
+
+void heap_free(queue_t *q)
+{
+    if (q->heap) {
+        free(q->heap->node);
+        free(q->heap);
+    }
+    q->heap = NULL;
+    q->heap_valid = false;
+}
+
+bool heap_sync(queue_t *q, bool max)
+{
+    struct pairheap *h = q->heap;
+    if (q->heap_valid && h->max == max)
+        return true;
+
+    if (!h) {
+        h = calloc(1, sizeof(*h));
+        if (!h)
+            return false;
+        q->heap = h;
+    }
+    h->used = 0;
+    if (!heap_reserve(h, q->size)) {
+        heap_free(q);
+        return false;
+    }
+
+    h->root = h->free = -1;
+    h->max = max;
+    element_t *e;
+    list_for_each_entry (e, &q->head, list)
+        h->root = heap_meld(h, h->root, heap_node_new(h, e));
+    q->heap_valid = true;
+    return true;
+}
+
+bool heap_push(queue_t *q, element_t *e)
+{
+    struct pairheap *h = q->heap;
+    if (h->free < 0 && !heap_reserve(h, h->used + 1))
+        return false;
+    h->root = heap_meld(h, h->root, heap_node_new(h, e));
+    return true;
+}
+
+element_t *heap_pop(queue_t *q)
+{
+    struct pairheap *h = q->heap;
+    int r = h->root;
+    element_t *e = h->node[r].e;
+
+    /* Meld the children in pairs from left to right, stacking the pairs */
+    int c = h->node[r].child, pairs = -1;
+    while (c >= 0) {
+        int a = c, b = h->node[a].next;
+        if (b < 0) {
+            h->node[a].next = pairs;
+            pairs = a;
+            break;
+        }
+        c = h->node[b].next;
+        h->node[a].next = h->node[b].next = -1;
+        int m = heap_meld(h, a, b);
+        h->node[m].next = pairs;
+        pairs = m;
+    }
+
+    /* Then meld the pairs into one heap from right to left */
+    int root = -1;
+    while (pairs >= 0) {
+        int next = h->node[pairs].next;
+        h->node[pairs].next = -1;
+        root = heap_meld(h, root, pairs);
+        pairs = next;
+    }
+    h->root = root;
+
+    h->node[r].next = h->free;
+    h->free = r;
+    return e;
+}
@@ -0,0 +1,58 @@
+#ifndef LAB0_PAIRHEAP_H
+#define LAB0_PAIRHEAP_H
+
+/* Pairing heap over the elements of a queue, behind q_insert_prio(),
+ * q_remove_min() and q_remove_max().
+ *
+ * The heap only tracks which elements are in the queue, not where: the list
+ * keeps its own order, and reordering it leaves the heap valid. Its nodes
+ * live in one array and refer to each other by index. Inserting melds a new
+ * node into the root in O(1); removing the root pairs its children up and
+ * melds the pairs back together, in O(log n) amortized. The heap keeps
+ * either the least or the greatest element at the root, whichever was last
+ * asked for. Every other operation adding or removing elements marks it
+ * stale, and the next heap_sync() rebuilds it from the list in O(n).
+ */
+
+#include <stdbool.h>
+
+#include "queue.h"
+
+static inline void heap_invalidate(queue_t *q)
+{
+    q->heap_valid = false;
+}
+
+/* Release the heap of @q, if any */
+void heap_free(queue_t *q);
+
+/**
+ * heap_sync() - Make sure the heap mirrors the queue, rebuilding it if stale
+ * @q: the queue
+ * @max: whether the greatest element is wanted at the root, else the least
+ *
+ * Return: true if the heap can be used, false if memory ran out
+ */
+bool heap_sync(queue_t *q, bool max);
+
+/**
+ * heap_push() - Add an element to a heap in sync
+ * @q: the queue
+ * @e: the element, already on the list
+ *
+ * Return: true for success, false if the heap could not grow. The heap is
+ * left as it was in that case, without @e.
+ */
+bool heap_push(queue_t *q, element_t *e);
+
+/**
+ * heap_pop() - Take the root off a heap in sync
+ * @q: the queue, not empty
+ *
+ * The element stays on the list: unlinking it is up to the caller.
+ *
+ * Return: the least element, or the greatest one, as heap_sync() was asked
+ */
+element_t *heap_pop(queue_t *q);
+
+#endif /* LAB0_PAIRHEAP_H */
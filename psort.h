@@ -0,0 +1,35 @@
+#ifndef LAB0_PSORT_H
+#define LAB0_PSORT_H
+
+#include <stddef.h>
+
+#include "list.h"
+
+/* Most threads list_psort() runs at once */
+#define PSORT_MAX_THREADS 64
+
+/**
+ * list_psort() - Sort a list with a merge sort spread over several threads
+ * @priv: private data passed through to @cmp
+ * @head: pointer to the head of the list
+ * @cmp: comparison function, see list_cmp_func_t; called from every thread
+ * @n: the number of nodes on @head
+ * @threads: the number of threads to use, the caller's included
+ *
+ * The list is cut into @threads contiguous segments, each one sorted by
+ * list_sort() on its own thread, then neighbouring segments are merged
+ * pairwise, the merges of a round running in parallel. Short lists use fewer
+ * threads, down to sorting on the caller's thread alone.
+ *
+ * The sort is stable and allocates no memory besides the stacks of the
+ * threads, which the harness does not see. SIGALRM stays blocked while the
+ * threads run, so an alarm raised meanwhile is only delivered once the sort
+ * is complete.
+ */
+void list_psort(void *priv,
+                struct list_head *head,
+                list_cmp_func_t cmp,
+                size_t n,
+                int threads);
+
+#endif /* LAB0_PSORT_H */
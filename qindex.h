@@ -0,0 +1,118 @@
+#ifndef LAB0_QINDEX_H
+#define LAB0_QINDEX_H
+
+/* Index of the elements of a queue, kept next to its list when the tree is
+ * built with one: "make INDEX=ring" (ring.c) keeps the elements in a circular
+ * array, "make INDEX=unrolled" (unrolled.c) in a list of fixed-size arrays.
+ *
+ * The index is a read-side cache, not the storage of the queue: the list stays
+ * authoritative, so that code walking the queue through list.h keeps working,
+ * and every element pays for its list node and its slot in the index alike.
+ * What the index buys is walks over arrays instead of pointer chasing, which
+ * turns whole-queue reorderings into array operations. Operations that change
+ * the list other than at its ends mark the index stale; it is rebuilt on
+ * demand by qindex_sync(). The reorderings run where memory may not be
+ * allocated, so the rebuild only reuses the storage of the index: while it is
+ * stale, insertions keep that storage large enough for the queue. Without an
+ * index every operation is a no-op and the index is never usable.
+ *
+ * Every function here expects @q->size to still count the elements before
+ * the change it mirrors.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+#ifdef QINDEX_UNROLLED
+
+/* Slots of each array of the unrolled index */
+#define QCHUNK_SLOTS 64
+
+/**
+ * struct qchunk - Array of consecutive elements of the unrolled index
+ * @link: node of the chunks list of queue_t
+ * @first: slot of the first element
+ * @count: the number of elements, which fill the slots from @first on
+ * @elem: the elements
+ * @key: their keys, see q_key()
+ */
+struct qchunk {
+    struct list_head link;
+    int first, count;
+    element_t *elem[QCHUNK_SLOTS];
+    uint64_t key[QCHUNK_SLOTS];
+};
+
+#endif /* QINDEX_UNROLLED */
+
+#ifdef QINDEX
+
+void qindex_init(queue_t *q);
+void qindex_free(queue_t *q);
+
+static inline void qindex_invalidate(queue_t *q)
+{
+    q->index_valid = false;
+}
+
+/**
+ * qindex_sync() - Make sure the index mirrors the list
+ * @q: the queue
+ *
+ * Rebuilding a stale index neither allocates nor frees memory.
+ *
+ * Return: true if the index can be used, false if it stays stale for lack of
+ * storage
+ */
+bool qindex_sync(queue_t *q);
+
+/* Make sure a stale index has the storage to be rebuilt with @n elements */
+void qindex_reserve(queue_t *q, size_t n);
+
+/* Mirror the insertion of @e at the head or tail of the list, or reserve
+ * storage for it if the index is stale
+ */
+void qindex_push(queue_t *q, element_t *e, bool tail);
+
+/* Mirror the removal of @n elements from the head or tail of the list */
+void qindex_pop(queue_t *q, size_t n, bool tail);
+
+/* The reorderings below work on an index in sync and relink the list to
+ * match. They allocate nothing.
+ */
+
+#ifdef QINDEX_RING
+/* Stable sort, using the second half of the ring as scratch space. The
+ * unrolled index has no room to spare for one: its queues are sorted on the
+ * list, and the chunks repacked by the next qindex_sync().
+ */
+bool qindex_sort(queue_t *q, bool descend);
+#endif
+
+/* Reverse every group of @k elements, leaving a trailing partial group as is.
+ * A @k of the queue size reverses the whole queue.
+ */
+bool qindex_reverseK(queue_t *q, size_t k);
+
+#else /* QINDEX */
+
+static inline void qindex_init(queue_t *q) {}
+static inline void qindex_free(queue_t *q) {}
+static inline void qindex_invalidate(queue_t *q) {}
+static inline bool qindex_sync(queue_t *q)
+{
+    return false;
+}
+static inline void qindex_reserve(queue_t *q, size_t n) {}
+static inline void qindex_push(queue_t *q, element_t *e, bool tail) {}
+static inline void qindex_pop(queue_t *q, size_t n, bool tail) {}
+static inline bool qindex_reverseK(queue_t *q, size_t k)
+{
+    return false;
+}
+
+#endif /* QINDEX */
+
+#endif /* LAB0_QINDEX_H */
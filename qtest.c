@@ -45,7 +45,9 @@ extern int show_entropy;
 #include "queue.h"
 
 #include "console.h"
+#include "mpmc.h"
 #include "report.h"
+#include "stress.h"
 
 /* Settable parameters */
 
@@ -75,6 +77,9 @@ static int string_length = MAXSTRING;
 
 static int descend = 0;
 
+/* Whether ih/it with a repeat count go through the bulk insertion API */
+static int bulk_insert = 0;
+
 #define MIN_RANDSTR_LEN 5
 #define MAX_RANDSTR_LEN 10
 static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
@@ -82,6 +87,7 @@ static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
 typedef enum {
     POS_TAIL,
     POS_HEAD,
+    POS_PRIO, /* first in sort order, following the descend param */
 } position_t;
 /* Forward declarations */
 static bool q_show(int vlevel);
@@ -181,6 +187,89 @@ static void fill_rand_string(char *buf, size_t buf_size)
 }
 
 /* insertion */
+/* Check the @r-th element inserted from the string @inserts, @lasts being the
+ * string of the element inserted before it
+ */
+static bool check_insert(element_t *entry,
+                         const char *inserts,
+                         const char *lasts,
+                         int r)
+{
+    char *cur_inserts = entry->value;
+    if (!cur_inserts) {
+        report(1, "ERROR: Failed to save copy of string in queue");
+        return false;
+    }
+    /* Strings of the intern pool live apart from their elements */
+    if (cur_inserts != entry->data && !q_intern_strings) {
+        report(1,
+               "ERROR: Need to store string inline after its queue element");
+        return false;
+    }
+    if (entry->key != q_key(cur_inserts)) {
+        report(1,
+               "ERROR: Cached key does not match the string of the queue "
+               "element");
+        return false;
+    }
+    if (r == 0 && inserts == cur_inserts) {
+        report(1,
+               "ERROR: Need to allocate and copy string for new queue "
+               "element");
+        return false;
+    }
+    if (r == 1 && lasts == cur_inserts && !q_intern_strings) {
+        report(1,
+               "ERROR: Need to allocate separate string for each queue "
+               "element");
+        return false;
+    }
+    return true;
+}
+
+/* Count a failed insertion, which is an error past the failure limit */
+static bool insert_failed(const char *inserts)
+{
+    fail_count++;
+    if (fail_count < fail_limit) {
+        report(2, "Insertion of %s failed", inserts);
+        return true;
+    }
+    report(1, "ERROR: Insertion of %s failed (%d failures total)", inserts,
+           fail_count);
+    return false;
+}
+
+/* Insert @sv[0] to @sv[reps - 1] with a single bulk call, then check them */
+static bool queue_insert_bulk(position_t pos, char **sv, int reps)
+{
+    bool rval = pos == POS_TAIL ? q_insert_tail_bulk(current->q, sv, reps)
+                                : q_insert_head_bulk(current->q, sv, reps);
+    if (!rval)
+        return insert_failed(sv[0]);
+
+    current->size += reps;
+    /* Walk the new elements from the first one linked, whose string is the
+     * last of @sv at head and the first one at tail
+     */
+    struct list_head *node = current->q;
+    if (pos == POS_TAIL) {
+        for (int r = 0; r < reps; r++)
+            node = node->prev;
+        node = node->prev;
+    }
+    const char *lasts = NULL;
+    for (int r = 0; r < reps; r++) {
+        node = node->next;
+        element_t *entry = list_entry(node, element_t, list);
+        char *inserts = sv[pos == POS_TAIL ? r : reps - 1 - r];
+        if (!check_insert(entry, inserts, lasts, r))
+            return false;
+        lasts = entry->value;
+    }
+    return true;
+}
+
 static bool queue_insert(position_t pos, int argc, char *argv[])
 {
     if (simulation) {
@@ -226,8 +315,32 @@ static bool queue_insert(position_t pos, int argc, char *argv[])
                pos == POS_TAIL ? "tail" : "head");
     error_check();
 
+    /* With the bulk option a repeat count makes a single bulk call, one string
+     * per element
+     */
+    char **sv = NULL, *rand_pool = NULL;
+    if (bulk_insert && argc == 3 && current && current->q && reps > 0) {
+        sv = malloc(reps * sizeof(*sv));
+        if (need_rand)
+            rand_pool = malloc((size_t) reps * MAX_RANDSTR_LEN);
+        if (!sv || (need_rand && !rand_pool)) {
+            free(sv);
+            free(rand_pool);
+            report(1, "INTERNAL ERROR.  Could not allocate %d strings", reps);
+            return false;
+        }
+        for (int r = 0; r < reps; r++) {
+            sv[r] = need_rand ? rand_pool + (size_t) r * MAX_RANDSTR_LEN
+                              : inserts;
+            if (need_rand)
+                fill_rand_string(sv[r], MAX_RANDSTR_LEN);
+        }
+    }
+
     if (current && exception_setup(true)) {
-        for (int r = 0; ok && r < reps; r++) {
+        if (sv)
+            ok = queue_insert_bulk(pos, sv, reps) && !error_check();
+        for (int r = 0; !sv && ok && r < reps; r++) {
             if (need_rand)
                 fill_rand_string(randstr_buf, sizeof(randstr_buf));
             bool rval = pos == POS_TAIL ? q_insert_tail(current->q, inserts)
@@ -238,39 +351,20 @@ static bool queue_insert(position_t pos, int argc, char *argv[])
                     pos == POS_TAIL
                         ? list_last_entry(current->q, element_t, list)
                         : list_first_entry(current->q, element_t, list);
-                char *cur_inserts = entry->value;
-                if (!cur_inserts) {
-                    report(1, "ERROR: Failed to save copy of string in queue");
-                    ok = false;
-                } else if (r == 0 && inserts == cur_inserts) {
-                    report(1,
-                           "ERROR: Need to allocate and copy string for new "
-                           "queue element");
-                    ok = false;
-                    break;
-                } else if (r == 1 && lasts == cur_inserts) {
-                    report(1,
-                           "ERROR: Need to allocate separate string for each "
-                           "queue element");
+                if (!check_insert(entry, inserts, lasts, r)) {
                     ok = false;
                     break;
                 }
-                lasts = cur_inserts;
+                lasts = entry->value;
             } else {
-                fail_count++;
-                if (fail_count < fail_limit)
-                    report(2, "Insertion of %s failed", inserts);
-                else {
-                    report(1,
-                           "ERROR: Insertion of %s failed (%d failures total)",
-                           inserts, fail_count);
-                    ok = false;
-                }
+                ok = insert_failed(inserts);
             }
             ok = ok && !error_check();
         }
     }
     exception_cancel();
+    free(sv);
+    free(rand_pool);
 
     q_show(3);
     return ok;
@@ -288,6 +382,293 @@ static bool do_it(int argc, char *argv[])
     return queue_insert(POS_TAIL, argc, argv);
 }
 
+/* Whether the current queue is sorted in ascending order */
+static bool queue_ascending()
+{
+    const element_t *prev = NULL, *item;
+    list_for_each_entry (item, current->q, list) {
+        if (prev && strcmp(prev->value, item->value) > 0)
+            return false;
+        prev = item;
+    }
+    return true;
+}
+
+/* insert in order */
+static bool do_isorted(int argc, char *argv[])
+{
+    char randstr_buf[MAX_RANDSTR_LEN];
+    int reps = 1;
+    bool ok = true;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+
+    char *inserts = argv[1];
+    if (argc == 3 && !get_int(argv[2], &reps)) {
+        report(1, "Invalid number of insertions '%s'", argv[2]);
+        return false;
+    }
+    bool need_rand = !strcmp(inserts, "RAND");
+    if (need_rand)
+        inserts = randstr_buf;
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling insert sorted on null queue");
+        return !error_check();
+    }
+    error_check();
+    if (!queue_ascending()) {
+        report(1, "ERROR: Queue must be sorted in ascending order");
+        return false;
+    }
+
+    /* Rebuilding a stale index frees all of its towers */
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+    if (exception_setup(true)) {
+        for (int r = 0; ok && r < reps; r++) {
+            if (need_rand)
+                fill_rand_string(randstr_buf, sizeof(randstr_buf));
+            if (q_insert_sorted(current->q, inserts)) {
+                current->size++;
+                element_t *entry = q_find(current->q, inserts);
+                if (!entry) {
+                    report(1, "ERROR: Inserted string %s not found", inserts);
+                    ok = false;
+                    break;
+                }
+                ok = check_insert(entry, inserts, NULL, 0);
+            } else {
+                ok = insert_failed(inserts);
+            }
+            ok = ok && !error_check();
+        }
+    }
+    exception_cancel();
+    set_cautious_mode(true);
+
+    if (ok && !queue_ascending()) {
+        report(1, "ERROR: Not sorted in ascending order after insertion");
+        ok = false;
+    }
+    q_show(3);
+    return ok;
+}
+
+/* insert into the priority heap */
+static bool do_iprio(int argc, char *argv[])
+{
+    char randstr_buf[MAX_RANDSTR_LEN];
+    int reps = 1;
+    bool ok = true;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+
+    char *inserts = argv[1];
+    if (argc == 3 && !get_int(argv[2], &reps)) {
+        report(1, "Invalid number of insertions '%s'", argv[2]);
+        return false;
+    }
+    bool need_rand = !strcmp(inserts, "RAND");
+    if (need_rand)
+        inserts = randstr_buf;
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling insert prio on null queue");
+        return !error_check();
+    }
+    error_check();
+
+    char *lasts = NULL;
+    if (exception_setup(true)) {
+        for (int r = 0; ok && r < reps; r++) {
+            if (need_rand)
+                fill_rand_string(randstr_buf, sizeof(randstr_buf));
+            if (q_insert_prio(current->q, inserts)) {
+                current->size++;
+                element_t *entry =
+                    list_last_entry(current->q, element_t, list);
+                ok = check_insert(entry, inserts, lasts, r);
+                lasts = entry->value;
+            } else {
+                ok = insert_failed(inserts);
+            }
+            ok = ok && !error_check();
+        }
+    }
+    exception_cancel();
+
+    q_show(3);
+    return ok;
+}
+
+static bool do_find(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs 1 argument", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Try to access null queue");
+        return false;
+    }
+    error_check();
+
+    element_t *found = NULL, *expect = NULL, *item;
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+    if (exception_setup(true))
+        found = q_find(current->q, argv[1]);
+    exception_cancel();
+    set_cautious_mode(true);
+
+    /* The first element holding the string is expected */
+    list_for_each_entry (item, current->q, list) {
+        if (!strcmp(item->value, argv[1])) {
+            expect = item;
+            break;
+        }
+    }
+    if (found != expect) {
+        report(1, "ERROR: Wrong element found for %s", argv[1]);
+        return false;
+    }
+    if (found)
+        report(1, "Found %s", argv[1]);
+    else
+        report(1, "%s not found", argv[1]);
+    return !error_check();
+}
+
+/* Check that no element left in queue comes before @re in sort order */
+static bool check_prio(const element_t *re)
+{
+    const element_t *item;
+    list_for_each_entry (item, current->q, list) {
+        int cmp = q_element_cmp(item, re);
+        if (descend ? cmp > 0 : cmp < 0) {
+            report(1, "ERROR: Removed %s while %s comes first", re->value,
+                   item->value);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Bytes of removed strings taken by each q_remove_head_n() call of rh/rt */
+#define REMOVE_ARENA_SIZE 65536
+
+/* Pack the strings q_remove_head_n() should hand back into @expect */
+static int expect_remove_n(position_t pos,
+                           int n,
+                           size_t *offsets,
+                           const q_arena_t *expect)
+{
+    int cnt = 0;
+    size_t used = 0;
+    struct list_head *node = current->q;
+    while (cnt < n) {
+        node = pos == POS_TAIL ? node->prev : node->next;
+        if (node == current->q)
+            break;
+        const char *s = list_entry(node, element_t, list)->value;
+        size_t len = strlen(s) + 1;
+        if (len > expect->size - used)
+            break;
+        memcpy(expect->buf + used, s, len);
+        offsets[cnt++] = used;
+        used += len;
+    }
+    return cnt;
+}
+
+/* Remove up to @argv[2] elements, all holding @argv[1] unless it is RAND */
+static bool queue_remove_n(position_t pos, int argc, char *argv[])
+{
+    int n;
+    if (!get_int(argv[2], &n) || n < 0) {
+        report(1, "Invalid number of removals '%s'", argv[2]);
+        return false;
+    }
+    const char *checks = strcmp(argv[1], "RAND") ? argv[1] : NULL;
+    if (!current || !current->q) {
+        report(3, "Warning: Calling remove %s on null queue",
+               pos == POS_TAIL ? "tail" : "head");
+        return !error_check();
+    }
+    error_check();
+
+    /* Each call can return at most one string per byte of the arena */
+    int batch = n < REMOVE_ARENA_SIZE ? n : REMOVE_ARENA_SIZE;
+    q_arena_t arena = {malloc(REMOVE_ARENA_SIZE), REMOVE_ARENA_SIZE};
+    q_arena_t expect = {malloc(REMOVE_ARENA_SIZE), REMOVE_ARENA_SIZE};
+    size_t *offsets = malloc((batch + 1) * sizeof(size_t));
+    size_t *expect_offsets = malloc((batch + 1) * sizeof(size_t));
+    bool ok = arena.buf && expect.buf && offsets && expect_offsets;
+    if (!ok)
+        report(1,
+               "INTERNAL ERROR.  Could not allocate space for removed strings");
+
+    /* Released elements are freed: skip the block lookup on each free */
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+    int removed = 0;
+    while (ok && removed < n && current->size) {
+        int want = n - removed < batch ? n - removed : batch;
+        int expected = expect_remove_n(pos, want, expect_offsets, &expect);
+        int got = 0;
+        if (exception_setup(true))
+            got = pos == POS_TAIL
+                      ? q_remove_tail_n(current->q, want, offsets, &arena)
+                      : q_remove_head_n(current->q, want, offsets, &arena);
+        exception_cancel();
+
+        if (got != expected) {
+            report(1, "ERROR: Removed %d elements, expected %d", got,
+                   expected);
+            ok = false;
+        } else if (!got) {
+            report(1, "ERROR: String too long to fit in %d bytes",
+                   REMOVE_ARENA_SIZE);
+            ok = false;
+        } else if (memcmp(offsets, expect_offsets, got * sizeof(size_t)) ||
+                   memcmp(arena.buf, expect.buf,
+                          expect_offsets[got - 1] +
+                              strlen(expect.buf + expect_offsets[got - 1]) +
+                              1)) {
+            report(1, "ERROR: Removed strings differ from the queue contents");
+            ok = false;
+        }
+        for (int i = 0; ok && checks && i < got; i++) {
+            if (strcmp(arena.buf + offsets[i], checks)) {
+                report(1, "ERROR: Removed value %s != expected value %s",
+                       arena.buf + offsets[i], checks);
+                ok = false;
+            }
+        }
+        if (got > 0) {
+            removed += got;
+            current->size -= got;
+        }
+        ok = ok && !error_check();
+    }
+    set_cautious_mode(true);
+    if (ok)
+        report(2, "Removed %d elements from queue", removed);
+
+    free(arena.buf);
+    free(expect.buf);
+    free(offsets);
+    free(expect_offsets);
+    q_show(3);
+    return ok && !error_check();
+}
+
 static bool queue_remove(position_t pos, int argc, char *argv[])
 {
     /* FIXME: It is known that both functions is_remove_tail_const() and
@@ -295,7 +676,7 @@ static bool queue_remove(position_t pos, int argc, char *argv[])
      * We shall figure out the exact reasons and resolve later.
      */
 #if !(defined(__aarch64__) && defined(__APPLE__))
-    if (simulation) {
+    if (simulation && pos != POS_PRIO) {
         if (argc != 1) {
             report(1, "%s does not need arguments in simulation mode", argv[0]);
             return false;
@@ -312,8 +693,10 @@ static bool queue_remove(position_t pos, int argc, char *argv[])
     }
 #endif
 
+    if (argc == 3 && pos != POS_PRIO)
+        return queue_remove_n(pos, argc, argv);
     if (argc != 1 && argc != 2) {
-        report(1, "%s needs 0-1 arguments", argv[0]);
+        report(1, "%s needs 0-%d arguments", argv[0], pos == POS_PRIO ? 1 : 2);
         return false;
     }
 
@@ -345,19 +728,28 @@ static bool queue_remove(position_t pos, int argc, char *argv[])
 
     if (!current || !current->size)
         report(3, "Warning: Calling remove %s on empty queue",
-               pos == POS_TAIL ? "tail" : "head");
+               pos == POS_PRIO ? "prio" : pos == POS_TAIL ? "tail" : "head");
     error_check();
 
     element_t *re = NULL;
-    if (current && exception_setup(true))
-        re = pos == POS_TAIL
-                 ? q_remove_tail(current->q, removes, string_length + 1)
-                 : q_remove_head(current->q, removes, string_length + 1);
+    if (current && exception_setup(true)) {
+        if (pos == POS_PRIO)
+            re = descend
+                     ? q_remove_max(current->q, removes, string_length + 1)
+                     : q_remove_min(current->q, removes, string_length + 1);
+        else
+            re = pos == POS_TAIL
+                     ? q_remove_tail(current->q, removes, string_length + 1)
+                     : q_remove_head(current->q, removes, string_length + 1);
+    }
     exception_cancel();
 
     bool is_null = re ? false : true;
 
     if (!is_null) {
+        if (pos == POS_PRIO && !check_prio(re))
+            ok = false;
+
         // q_remove_head and q_remove_tail are not responsible for releasing
         // node
         q_release_element(re);
@@ -417,6 +809,55 @@ static inline bool do_rt(int argc, char *argv[])
     return queue_remove(POS_TAIL, argc, argv);
 }
 
+static inline bool do_rmprio(int argc, char *argv[])
+{
+    return queue_remove(POS_PRIO, argc, argv);
+}
+
+/* A copied string and its position in the queue */
+struct dup_item {
+    const char *value;
+    size_t pos;
+};
+
+static int cmp_dup_item(const void *a, const void *b)
+{
+    return strcmp(((const struct dup_item *) a)->value,
+                  ((const struct dup_item *) b)->value);
+}
+
+/* Flag, by position, every copy whose string occurs more than once. The
+ * caller frees the flags.
+ */
+static bool *mark_dups(struct list_head *l_copy, size_t n)
+{
+    struct dup_item *items = malloc(n * sizeof(*items));
+    bool *dups = malloc(n * sizeof(*dups));
+    if (!items || !dups) {
+        free(items);
+        free(dups);
+        return NULL;
+    }
+
+    element_t *item;
+    size_t i = 0;
+    list_for_each_entry (item, l_copy, list) {
+        items[i].value = item->value;
+        items[i].pos = i;
+        i++;
+    }
+    qsort(items, n, sizeof(*items), cmp_dup_item);
+
+    for (i = 0; i < n; i++) {
+        bool same_prev = i > 0 && !strcmp(items[i - 1].value, items[i].value);
+        bool same_next =
+            i + 1 < n && !strcmp(items[i + 1].value, items[i].value);
+        dups[items[i].pos] = same_prev || same_next;
+    }
+    free(items);
+    return dups;
+}
+
 static bool do_dedup(int argc, char *argv[])
 {
     if (argc != 1) {
@@ -431,30 +872,26 @@ static bool do_dedup(int argc, char *argv[])
 
     LIST_HEAD(l_copy);
     element_t *item = NULL, *tmp = NULL;
+    bool *dups = NULL;
 
     // Copy current->q to l_copy
     if (current->q && !list_empty(current->q)) {
         list_for_each_entry (item, current->q, list) {
-            size_t slen;
-            tmp = malloc(sizeof(element_t));
+            size_t slen = strlen(item->value) + 1;
+            tmp = malloc(sizeof(element_t) + slen);
             if (!tmp)
                 break;
             INIT_LIST_HEAD(&tmp->list);
-            slen = strlen(item->value) + 1;
-            tmp->value = malloc(slen);
-            if (!tmp->value) {
-                free(tmp);
-                break;
-            }
-            memcpy(tmp->value, item->value, slen);
+            tmp->value = memcpy(tmp->data, item->value, slen);
             list_add_tail(&tmp->list, &l_copy);
         }
         // Return false if the loop does not leave properly
-        if (&item->list != current->q) {
-            list_for_each_entry_safe (item, tmp, &l_copy, list) {
-                free(item->value);
+        bool marked = q_dedup_mode != DEDUP_HASH ||
+                      (&item->list == current->q &&
+                       (dups = mark_dups(&l_copy, current->size)));
+        if (&item->list != current->q || !marked) {
+            list_for_each_entry_safe (item, tmp, &l_copy, list)
                 free(item);
-            }
             report(1,
                    "INTERNAL ERROR.  Could not allocate space for "
                    "duplicate checking");
@@ -462,22 +899,28 @@ static bool do_dedup(int argc, char *argv[])
         }
     }
 
+    /* Removed nodes are freed: skip the block lookup on each free */
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+
     bool ok = true;
     if (exception_setup(true))
         ok = q_delete_dup(current->q);
     exception_cancel();
+    set_cautious_mode(true);
 
     if (!ok) {
-        list_for_each_entry_safe (item, tmp, &l_copy, list) {
-            free(item->value);
+        list_for_each_entry_safe (item, tmp, &l_copy, list)
             free(item);
-        }
-        report(1, "ERROR: Calling delete duplicate on null queue");
+        free(dups);
+        report(1, "ERROR: Calling delete duplicate on null queue or running "
+                  "out of memory");
         return false;
     }
 
     struct list_head *l_tmp = current->q->next;
     bool is_this_dup = false;
+    size_t pos = 0;
     // Compare between new list and old one
     list_for_each_entry (item, &l_copy, list) {
         // Skip comparison with new list if the string is duplicate
@@ -485,7 +928,10 @@ static bool do_dedup(int argc, char *argv[])
             item->list.next != &l_copy &&
             strcmp(list_entry(item->list.next, element_t, list)->value,
                    item->value) == 0;
-        if (is_this_dup || is_next_dup) {
+        // Without sorting, duplicates are only known from the marks
+        bool is_dup = q_dedup_mode == DEDUP_HASH ? dups[pos++]
+                                                 : is_this_dup || is_next_dup;
+        if (is_dup) {
             // Update list size
             current->size--;
         } else if (l_tmp != current->q &&
@@ -503,10 +949,9 @@ static bool do_dedup(int argc, char *argv[])
                "ERROR: Duplicate strings are in queue or distinct strings are "
                "not in queue");
 
-    list_for_each_entry_safe (item, tmp, &l_copy, list) {
-        free(item->value);
+    list_for_each_entry_safe (item, tmp, &l_copy, list)
         free(item);
-    }
+    free(dups);
 
     q_show(3);
     return ok && !error_check();
@@ -535,6 +980,21 @@ static bool do_reverse(int argc, char *argv[])
 
 static bool do_size(int argc, char *argv[])
 {
+    if (simulation) {
+        if (argc != 1) {
+            report(1, "%s does not need arguments in simulation mode", argv[0]);
+            return false;
+        }
+        bool ok = is_size_const();
+        if (!ok) {
+            report(1,
+                   "ERROR: Probably not constant time or wrong implementation");
+            return false;
+        }
+        report(1, "Probably constant time");
+        return ok;
+    }
+
     if (argc != 1 && argc != 2) {
         report(1, "%s takes 0-1 arguments", argv[0]);
         return false;
@@ -625,20 +1085,20 @@ bool do_sort(int argc, char *argv[])
             element_t *item, *next_item;
             item = list_entry(cur_l, element_t, list);
             next_item = list_entry(cur_l->next, element_t, list);
-            if (!descend && strcmp(item->value, next_item->value) > 0) {
+            if (!descend && q_element_cmp(item, next_item) > 0) {
                 report(1, "ERROR: Not sorted in ascending order");
                 ok = false;
                 break;
             }
 
-            if (descend && strcmp(item->value, next_item->value) < 0) {
+            if (descend && q_element_cmp(item, next_item) < 0) {
                 report(1, "ERROR: Not sorted in descending order");
                 ok = false;
                 break;
             }
             /* Ensure the stability of the sort */
             if (current->size <= MAX_NODES &&
-                !strcmp(item->value, next_item->value)) {
+                !q_element_cmp(item, next_item)) {
                 bool unstable = false;
                 for (unsigned i = 0; i < MAX_NODES; i++) {
                     if (nodes[i] == cur_l->next) {
@@ -667,10 +1127,26 @@ bool do_sort(int argc, char *argv[])
     return ok && !error_check();
 }
 
+/* The neighbours of the middle node, which q_delete_mid() should link up */
+static void middle_links(struct list_head **prev, struct list_head **next)
+{
+    struct list_head *node = current->q->next;
+    for (int i = current->size / 2; i > 0; i--)
+        node = node->next;
+    *prev = node->prev;
+    *next = node->next;
+}
+
 static bool do_dm(int argc, char *argv[])
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    if (argc != 1 && argc != 2) {
+        report(1, "%s takes 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    int reps = 1;
+    if (argc == 2 && !get_int(argv[1], &reps)) {
+        report(1, "Invalid number of deletions '%s'", argv[1]);
         return false;
     }
 
@@ -681,14 +1157,33 @@ static bool do_dm(int argc, char *argv[])
     error_check();
 
     bool ok = true;
-    if (exception_setup(true))
-        ok = q_delete_mid(current->q);
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+    if (exception_setup(true)) {
+        for (int r = 0; ok && r < reps; r++) {
+            if (!current->size) {
+                report(3, "Warning: Try to delete middle node to empty queue");
+                ok = q_delete_mid(current->q);
+                break;
+            }
+
+            /* Check which node went on short queues only */
+            struct list_head *prev = NULL, *next = NULL;
+            if (current->size <= BIG_LIST_SIZE)
+                middle_links(&prev, &next);
+            ok = q_delete_mid(current->q);
+            if (ok)
+                --current->size;
+            if (ok && prev && prev->next != next) {
+                report(1, "ERROR: Deleted another node than the middle one");
+                ok = false;
+            }
+            ok = ok && !error_check();
+        }
+    }
     exception_cancel();
+    set_cautious_mode(true);
 
-    if (!current->size)
-        report(3, "Warning: Try to delete middle node to empty queue");
-    else
-        --current->size;
     q_show(3);
     return ok && !error_check();
 }
@@ -739,8 +1234,14 @@ static bool do_ascend(int argc, char *argv[])
         report(3, "Warning: Calling ascend on single node");
     error_check();
 
+    /* Removed nodes are freed: skip the block lookup on each free */
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+
     if (exception_setup(true))
         current->size = q_ascend(current->q);
+    exception_cancel();
+    set_cautious_mode(true);
     set_noallocate_mode(false);
 
     bool ok = true;
@@ -752,7 +1253,7 @@ static bool do_ascend(int argc, char *argv[])
             element_t *item, *next_item;
             item = list_entry(cur_l, element_t, list);
             next_item = list_entry(cur_l->next, element_t, list);
-            if (strcmp(item->value, next_item->value) > 0) {
+            if (q_element_cmp(item, next_item) > 0) {
                 report(1,
                        "ERROR: At least one node violated the ordering rule");
                 ok = false;
@@ -786,8 +1287,14 @@ static bool do_descend(int argc, char *argv[])
         report(3, "Warning: Calling descend on single node");
     error_check();
 
+    /* Removed nodes are freed: skip the block lookup on each free */
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+
     if (exception_setup(true))
         current->size = q_descend(current->q);
+    exception_cancel();
+    set_cautious_mode(true);
     set_noallocate_mode(false);
 
     bool ok = true;
@@ -799,7 +1306,7 @@ static bool do_descend(int argc, char *argv[])
             element_t *item, *next_item;
             item = list_entry(cur_l, element_t, list);
             next_item = list_entry(cur_l->next, element_t, list);
-            if (strcmp(item->value, next_item->value) < 0) {
+            if (q_element_cmp(item, next_item) < 0) {
                 report(1,
                        "ERROR: At least one node violated the ordering rule");
                 ok = false;
@@ -862,7 +1369,7 @@ static bool do_merge(int argc, char *argv[])
     exception_cancel();
     set_noallocate_mode(false);
 
-    if (q_size(&chain.head) > 1) {
+    if (chain.size > 1) {
         chain.size = 1;
         current = list_entry(chain.head.next, queue_contex_t, chain);
         current->size = len;
@@ -887,7 +1394,7 @@ static bool do_merge(int argc, char *argv[])
             element_t *item, *next_item;
             item = list_entry(cur_l, element_t, list);
             next_item = list_entry(cur_l->next, element_t, list);
-            if (!descend && strcmp(item->value, next_item->value) > 0) {
+            if (!descend && q_element_cmp(item, next_item) > 0) {
                 report(1,
                        "ERROR: Not sorted in ascending order (It might because "
                        "of unsorted queues are merged or there're some flaws "
@@ -897,7 +1404,7 @@ static bool do_merge(int argc, char *argv[])
             }
 
 
-            if (descend && strcmp(item->value, next_item->value) < 0) {
+            if (descend && q_element_cmp(item, next_item) < 0) {
                 report(
                     1,
                     "ERROR: Not sorted in descending order (It might because "
@@ -937,6 +1444,90 @@ static bool is_circular()
     return true;
 }
 
+/* Parse the optional "producers consumers [n]" arguments of a stress
+ * command
+ */
+static bool stress_args(int argc,
+                        char *argv[],
+                        int *producers,
+                        int *consumers,
+                        int *n)
+{
+    if (argc != 1 && argc != 3 && argc != 4) {
+        report(1, "%s takes 0, 2 or 3 arguments", argv[0]);
+        return false;
+    }
+    if (argc >= 3 && (!get_int(argv[1], producers) || *producers <= 0 ||
+                      !get_int(argv[2], consumers) || *consumers <= 0)) {
+        report(1, "Invalid number of threads");
+        return false;
+    }
+    if (argc == 4 && (!get_int(argv[3], n) || *n <= 0)) {
+        report(1, "Invalid number of elements '%s'", argv[3]);
+        return false;
+    }
+    return true;
+}
+
+static bool do_mpmc(int argc, char *argv[])
+{
+    int producers = 2, consumers = 2, n = 100000;
+    if (!stress_args(argc, argv, &producers, &consumers, &n))
+        return false;
+    if (producers + consumers > MPMC_MAX_THREADS) {
+        report(1, "At most %d threads", MPMC_MAX_THREADS);
+        return false;
+    }
+    return stress_mpmc(producers, consumers, n);
+}
+
+static bool do_twolock(int argc, char *argv[])
+{
+    int producers = 2, consumers = 2, n = 100000;
+    if (!stress_args(argc, argv, &producers, &consumers, &n))
+        return false;
+    return stress_twolock(producers, consumers, n);
+}
+
+static bool do_spsc(int argc, char *argv[])
+{
+    int n = 1000000, batch = 1;
+    if (argc > 3) {
+        report(1, "%s takes 0-2 arguments", argv[0]);
+        return false;
+    }
+    if (argc > 1 && (!get_int(argv[1], &n) || n <= 0)) {
+        report(1, "Invalid number of messages '%s'", argv[1]);
+        return false;
+    }
+    if (argc > 2 && (!get_int(argv[2], &batch) || batch <= 0 ||
+                     batch > SPSC_MAX_BATCH)) {
+        report(1, "Batch size must be between 1 and %d", SPSC_MAX_BATCH);
+        return false;
+    }
+    return stress_spsc(n, batch);
+}
+
+static bool do_forkjoin(int argc, char *argv[])
+{
+    int nworkers = 4, n = 100000;
+    if (argc > 3) {
+        report(1, "%s takes 0-2 arguments", argv[0]);
+        return false;
+    }
+    if (argc > 1 && (!get_int(argv[1], &nworkers) || nworkers <= 0 ||
+                     nworkers > FORKJOIN_MAX_WORKERS)) {
+        report(1, "Number of workers must be between 1 and %d",
+               FORKJOIN_MAX_WORKERS);
+        return false;
+    }
+    if (argc > 2 && (!get_int(argv[2], &n) || n <= 0)) {
+        report(1, "Invalid number of tasks '%s'", argv[2]);
+        return false;
+    }
+    return stress_forkjoin(nworkers, n);
+}
+
 static bool q_show(int vlevel)
 {
     bool ok = true;
@@ -1070,19 +1661,37 @@ static void console_init()
                 "Insert string str at tail of queue n times. Generate random "
                 "string(s) if str equals RAND. (default: n == 1)",
                 "str [n]");
-    ADD_COMMAND(
-        rh,
-        "Remove from head of queue. Optionally compare to expected value str",
-        "[str]");
-    ADD_COMMAND(
-        rt,
-        "Remove from tail of queue. Optionally compare to expected value str",
-        "[str]");
+    ADD_COMMAND(isorted,
+                "Insert string str n times into queue sorted in ascending "
+                "order. Generate random string(s) if str equals RAND. "
+                "(default: n == 1)",
+                "str [n]");
+    ADD_COMMAND(iprio,
+                "Insert string str n times at tail of queue and into its "
+                "priority heap. Generate random string(s) if str equals "
+                "RAND. (default: n == 1)",
+                "str [n]");
+    ADD_COMMAND(find, "Look up string str in queue", "str");
+    ADD_COMMAND(rh,
+                "Remove from head of queue. Optionally compare to expected "
+                "value str. With n, remove n elements in batches, each "
+                "compared to str unless it equals RAND",
+                "[str [n]]");
+    ADD_COMMAND(rt,
+                "Remove from tail of queue. Optionally compare to expected "
+                "value str. With n, remove n elements in batches, each "
+                "compared to str unless it equals RAND",
+                "[str [n]]");
+    ADD_COMMAND(rmprio,
+                "Remove the first element in ascending/descending order. "
+                "Optionally compare to expected value str",
+                "[str]");
     ADD_COMMAND(reverse, "Reverse queue", "");
     ADD_COMMAND(sort, "Sort queue in ascending/descening order", "");
     ADD_COMMAND(size, "Compute queue size n times (default: n == 1)", "[n]");
     ADD_COMMAND(show, "Show queue contents", "");
-    ADD_COMMAND(dm, "Delete middle node in queue", "");
+    ADD_COMMAND(dm, "Delete middle node in queue n times (default: n == 1)",
+                "[n]");
     ADD_COMMAND(dedup, "Delete all nodes that have duplicate string", "");
     ADD_COMMAND(merge, "Merge all the queues into one sorted queue", "");
     ADD_COMMAND(swap, "Swap every two adjacent nodes in queue", "");
@@ -1096,6 +1705,22 @@ static void console_init()
                 "");
     ADD_COMMAND(reverseK, "Reverse the nodes of the queue 'K' at a time",
                 "[K]");
+    ADD_COMMAND(mpmc,
+                "Pass n elements from producer to consumer threads through "
+                "a lock-free queue (default: 2 2 100000)",
+                "[producers consumers [n]]");
+    ADD_COMMAND(spsc,
+                "Pass n messages from a producer to a consumer thread "
+                "through a ring, batch at a time (default: 1000000 1)",
+                "[n [batch]]");
+    ADD_COMMAND(twolock,
+                "Pass n elements from producer to consumer threads through "
+                "a two-lock blocking queue (default: 2 2 100000)",
+                "[producers consumers [n]]");
+    ADD_COMMAND(forkjoin,
+                "Run a binary tree of n tasks on workers stealing from "
+                "each other's deques (default: 4 100000)",
+                "[workers [n]]");
     add_param("length", &string_length, "Maximum length of displayed string",
               NULL);
     add_param("malloc", &fail_probability, "Malloc failure probability percent",
@@ -1104,6 +1729,17 @@ static void console_init()
               "Number of times allow queue operations to return false", NULL);
     add_param("descend", &descend,
               "Sort and merge queue in ascending/descending order", NULL);
+    add_param("sort", &q_sort_mode,
+              "Sort algorithm (0: merge sort, 1: timsort, 2: radix sort)",
+              NULL);
+    add_param("threads", &q_sort_threads,
+              "Threads merge sort runs on (1: no parallelism)", NULL);
+    add_param("dedup", &q_dedup_mode,
+              "Duplicate removal (0: adjacent, 1: hash table)", NULL);
+    add_param("bulk", &bulk_insert,
+              "Insert repeated ih/it strings with a single bulk call", NULL);
+    add_param("intern", &q_intern_strings,
+              "Share equal strings through a refcounted pool", NULL);
 }
 
 /* Signal handlers */
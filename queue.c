@@ -3,6 +3,11 @@
 #include <string.h>
 
 #include "queue.h"
+#include "pairheap.h"
+#include "psort.h"
+#include "qindex.h"
+#include "skiplist.h"
+#include "timsort.h"
 
 /* Notice: sometimes, Cppcheck would find the potential NULL pointer bugs,
  * but some of them cannot occur. You can suppress them by adding the
@@ -10,62 +15,191 @@
  *   cppcheck-suppress nullPointer
  */
 
-void q_merge_two(struct list_head *first,
-                 struct list_head *second,
-                 bool descend);
+int q_sort_mode = SORT_MERGE;
+int q_sort_threads = 1;
+int q_dedup_mode = DEDUP_ADJACENT;
+int q_intern_strings = 0;
 
+/* Recover the queue header from the list head handed out by q_new() */
+static inline queue_t *q_header(struct list_head *head)
+{
+    return list_entry(head, queue_t, head);
+}
 
-/* Insert node into queue */
-static inline bool q_insert(struct list_head *node, const char *s)
+static inline void mid_invalidate(queue_t *q)
 {
-    if (!node) /* input validation */
-        return false;
+    q->mid_valid = false;
+}
 
-    /* allocate space for new item */
-    element_t *new = malloc(sizeof(element_t));
+/* Drop the indexes that cannot follow a change to the list */
+static inline void q_invalidate(queue_t *q)
+{
+    qindex_invalidate(q);
+    skip_invalidate(q);
+    heap_invalidate(q);
+    mid_invalidate(q);
+}
+
+/* Follow the middle to the insertion of @node at one end, @q->size still
+ * counting the elements before
+ */
+static inline void mid_push(queue_t *q, struct list_head *node, bool tail)
+{
+    if (!q->mid_valid)
+        return;
+    if (!q->size)
+        q->mid = node;
+    else if (tail && (q->size & 1))
+        q->mid = q->mid->next;
+    else if (!tail && !(q->size & 1))
+        q->mid = q->mid->prev;
+}
+
+/* Follow the middle to the removal of the element at one end, before it is
+ * unlinked
+ */
+static inline void mid_pop(queue_t *q, bool tail)
+{
+    if (!q->mid_valid)
+        return;
+    if (q->size == 1)
+        q->mid = &q->head;
+    else if (tail && !(q->size & 1))
+        q->mid = q->mid->prev;
+    else if (!tail && (q->size & 1))
+        q->mid = q->mid->next;
+}
+
+/* Allocate an element holding a copy of @s */
+static inline element_t *q_element_new(const char *s)
+{
+    if (q_intern_strings) {
+        element_t *new = malloc(sizeof(element_t));
+        if (!new)
+            return NULL;
+        new->value = intern_get(s, 1);
+        if (!new->value) {
+            free(new);
+            return NULL;
+        }
+        new->key = q_key(new->value);
+        new->len = strlen(new->value);
+        new->chunk = NULL;
+        return new;
+    }
+
+    /* allocate space for new item and its string in one go */
+    size_t len = strlen(s);
+    element_t *new = malloc(sizeof(element_t) + len + 1);
 
     if (!new)
-        return false; /* memory allocation failure */
+        return NULL; /* memory allocation failure */
+
+    new->value = memcpy(new->data, s, len + 1);
+    new->key = q_key(new->value);
+    new->len = len;
+    new->chunk = NULL;
+    return new;
+}
+
+/* Insert node into queue */
+static inline bool q_insert(struct list_head *head,
+                            struct list_head *node,
+                            const char *s)
+{
+    if (!head) /* input validation */
+        return false;
 
-    new->value = malloc(sizeof(char) * (strlen(s) + 1));
-    /* input validation and memory allocation detection */
-    if (!new->value) {
-        free(new);
+    element_t *new = q_element_new(s);
+    if (!new)
         return false;
-    }
 
-    new->value = strncpy(new->value, s, (strlen(s) + 1));
+    qindex_push(q_header(head), new, node != head);
+    skip_invalidate(q_header(head));
     list_add(&new->list, node);
+    mid_push(q_header(head), &new->list, node != head);
+    q_header(head)->size++;
 
     return true;
 }
 
-static inline element_t *q_remove(struct list_head *node,
+static inline element_t *q_remove(struct list_head *head,
+                                  struct list_head *node,
                                   char *sp,
                                   size_t bufsize)
 {
-    element_t *element = list_entry(node, element_t, list);
-
-    if (!element)
+    if (!head || list_empty(head))
         return NULL;
 
+    element_t *element = list_entry(node, element_t, list);
+
+    /* Copy no more than the string, rather than padding all of @sp */
     if (sp) {
-        strncpy(sp, list_entry(node, element_t, list)->value, bufsize);
-        sp[bufsize - 1] = '\0';
+        size_t len = element->len < bufsize - 1 ? element->len : bufsize - 1;
+        memcpy(sp, element->value, len);
+        sp[len] = '\0';
     }
 
+    queue_t *q = q_header(head);
+    if (q->skip_valid)
+        skip_delete_at(q, node == head->next ? 0 : q->size - 1);
+    qindex_pop(q, 1, node != head->next);
+    mid_pop(q, node != head->next);
     list_del_init(node);
+    q_header(head)->size--;
     return element;
 }
 
+/* Unlink an element from queue and release it */
+static inline void q_delete(struct list_head *head, element_t *element)
+{
+    q_invalidate(q_header(head));
+    list_del(&element->list);
+    q_release_element(element);
+    q_header(head)->size--;
+}
+
+/* Release every element on @list, which belongs to no queue. Each run of
+ * elements sharing a bulk chunk drops its references on it at once.
+ */
+static void q_release_list(struct list_head *list)
+{
+    struct list_head *node = list->next;
+    while (node != list) {
+        element_t *element = list_entry(node, element_t, list);
+        q_chunk_t *chunk = element->chunk;
+        size_t run = 0;
+        do {
+            if (element->value != element->data)
+                intern_put(element->value);
+            node = node->next;
+            run++;
+            if (!chunk)
+                test_free(element);
+            element = list_entry(node, element_t, list);
+        } while (chunk && node != list && element->chunk == chunk);
+
+        if (chunk && !(chunk->refs -= run))
+            test_free(chunk);
+    }
+}
+
 /* Create an empty queue */
 struct list_head *q_new()
 {
-    struct list_head *head = malloc(sizeof(struct list_head));
-    if (!head)
+    queue_t *q = malloc(sizeof(queue_t));
+    if (!q)
         return NULL;
-    INIT_LIST_HEAD(head);
-    return head;
+    INIT_LIST_HEAD(&q->head);
+    q->size = 0;
+    qindex_init(q);
+    q->skip = NULL;
+    q->skip_valid = false;
+    q->heap = NULL;
+    q->heap_valid = false;
+    q->mid = &q->head;
+    q->mid_valid = true;
+    return &q->head;
 }
 
 /* Free all storage used by queue */
@@ -74,12 +208,11 @@ void q_free(struct list_head *head)
     if (!head)
         return;
 
-    struct list_head *curr, *safe;
-    list_for_each_safe (curr, safe, head) {
-        element_t *node = list_entry(curr, element_t, list);
-        q_release_element(node);
-    }
-    free(head);
+    q_release_list(head);
+    qindex_free(q_header(head));
+    skip_free(q_header(head));
+    heap_free(q_header(head));
+    free(q_header(head));
 }
 
 /* Insert an element at head of queue */
@@ -87,7 +220,10 @@ bool q_insert_head(struct list_head *head, char *s)
 {
     volatile char *dummy = s;
     (void) dummy;
-    return q_insert(head, s);
+    if (!head)
+        return false;
+    heap_invalidate(q_header(head));
+    return q_insert(head, head, s);
 }
 
 /* Insert an element at tail of queue */
@@ -95,33 +231,273 @@ bool q_insert_tail(struct list_head *head, char *s)
 {
     volatile char *dummy = s;
     (void) dummy;
-    return q_insert(head->prev, s);
+    if (!head)
+        return false;
+    heap_invalidate(q_header(head));
+    return q_insert(head, head->prev, s);
+}
+
+/* Room taken in a bulk chunk by the element holding a string of @len bytes,
+ * terminator included, rounded up to keep the next element aligned
+ */
+static inline size_t q_chunk_stride(size_t len)
+{
+    return (sizeof(element_t) + len + 7) & ~(size_t) 7;
+}
+
+/* Insert the strings of @sv as one chunk of elements, before @node */
+static bool q_insert_bulk(struct list_head *head,
+                          struct list_head *node,
+                          char **sv,
+                          int n,
+                          bool reversed)
+{
+    if (!head || n < 0 || (n && !sv))
+        return false;
+    if (!n)
+        return true;
+
+    /* Repeated strings, as qtest passes them, are measured only once */
+    bool intern = q_intern_strings;
+    size_t total = sizeof(q_chunk_t), len = 0;
+    for (int i = 0; i < n; i++) {
+        if (!i || sv[i] != sv[i - 1])
+            len = intern ? 0 : strlen(sv[i]) + 1;
+        total += q_chunk_stride(len);
+    }
+
+    q_chunk_t *chunk = malloc(total);
+    if (!chunk)
+        return false;
+    chunk->refs = n;
+
+    /* Link the elements on a private list, then splice it in one go */
+    LIST_HEAD(batch);
+    char *p = (char *) (chunk + 1);
+    uint64_t key = 0;
+    size_t slen = 0;
+    char *value = NULL;
+    for (int i = 0; i < n; i++) {
+        if (!i || sv[i] != sv[i - 1]) {
+            if (intern && !(value = intern_get(sv[i], 1))) {
+                element_t *element;
+                list_for_each_entry (element, &batch, list)
+                    intern_put(element->value);
+                free(chunk);
+                return false;
+            }
+            slen = strlen(sv[i]);
+            len = intern ? 0 : slen + 1;
+            key = q_key(sv[i]);
+        } else if (intern) {
+            intern_of(value)->refs++;
+        }
+        element_t *new = (element_t *) p;
+        new->value = intern ? value : memcpy(new->data, sv[i], len);
+        new->key = key;
+        new->len = slen;
+        new->chunk = chunk;
+        if (reversed)
+            list_add(&new->list, &batch);
+        else
+            list_add_tail(&new->list, &batch);
+        p += q_chunk_stride(len);
+    }
+    queue_t *q = q_header(head);
+    skip_invalidate(q);
+    heap_invalidate(q);
+
+    /* Mirror the elements in the order single insertions would link them */
+    bool tail = !reversed;
+    struct list_head *pos = tail ? batch.next : batch.prev;
+    list_splice(&batch, node);
+    for (int i = 0; i < n; i++, pos = tail ? pos->next : pos->prev) {
+        qindex_push(q, list_entry(pos, element_t, list), tail);
+        mid_push(q, pos, tail);
+        q->size++;
+    }
+    return true;
+}
+
+/* Insert many elements at head of queue */
+bool q_insert_head_bulk(struct list_head *head, char **sv, int n)
+{
+    return q_insert_bulk(head, head, sv, n, true);
+}
+
+/* Insert many elements at tail of queue */
+bool q_insert_tail_bulk(struct list_head *head, char **sv, int n)
+{
+    if (!head)
+        return false;
+    return q_insert_bulk(head, head->prev, sv, n, false);
+}
+
+/* Insert an element into a queue sorted in ascending order */
+bool q_insert_sorted(struct list_head *head, char *s)
+{
+    if (!head)
+        return false;
+
+    queue_t *q = q_header(head);
+    if (!skip_sync(q))
+        return false;
+    element_t *new = q_element_new(s);
+    if (!new)
+        return false;
+
+    qindex_invalidate(q);
+    qindex_reserve(q, q->size + 1);
+    heap_invalidate(q);
+    mid_invalidate(q);
+    skip_insert(q, new);
+    q->size++;
+    return true;
+}
+
+/* Insert an element at tail of queue and into its heap */
+bool q_insert_prio(struct list_head *head, char *s)
+{
+    if (!head)
+        return false;
+
+    /* Linking the element is the same as for q_insert_tail() */
+    queue_t *q = q_header(head);
+    if (!q_insert(head, head->prev, s))
+        return false;
+    if (q->heap_valid && !heap_push(q, list_last_entry(head, element_t, list)))
+        heap_invalidate(q);
+    return true;
 }
 
 /* Remove an element from head of queue */
 element_t *q_remove_head(struct list_head *head, char *sp, size_t bufsize)
 {
-    if (!head || list_empty(head))
+    if (!head)
         return NULL;
+    heap_invalidate(q_header(head));
+    return q_remove(head, head->next, sp, bufsize);
+}
 
-    element_t *element = list_entry(head->next, element_t, list);
+/* Remove an element from tail of queue */
+element_t *q_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return NULL;
+    heap_invalidate(q_header(head));
+    return q_remove(head, head->prev, sp, bufsize);
+}
 
-    if (!element)
+/* Remove the least element, or the greatest one if @max */
+static element_t *q_remove_prio(struct list_head *head,
+                                char *sp,
+                                size_t bufsize,
+                                bool max)
+{
+    if (!head || list_empty(head))
         return NULL;
-    if (sp) {
-        strncpy(sp, list_entry(head->next, element_t, list)->value, bufsize);
-        sp[bufsize - 1] = '\0';
+
+    queue_t *q = q_header(head);
+    element_t *element;
+    if (heap_sync(q, max)) {
+        element = heap_pop(q);
+    } else {
+        /* No memory for the heap: look at every element */
+        element_t *e;
+        element = list_first_entry(head, element_t, list);
+        list_for_each_entry (e, head, list) {
+            int cmp = q_element_cmp(e, element);
+            if (max ? cmp > 0 : cmp < 0)
+                element = e;
+        }
     }
 
-    list_del_init(head->next);
-    return element;
-    // return q_remove(head->next, sp, bufsize);
+    /* The indexes only follow removals at either end */
+    struct list_head *node = &element->list;
+    if (node != head->next && node != head->prev) {
+        qindex_invalidate(q);
+        skip_invalidate(q);
+        mid_invalidate(q);
+    }
+    return q_remove(head, node, sp, bufsize);
 }
 
-/* Remove an element from tail of queue */
-element_t *q_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+/* Remove the least element of queue */
+element_t *q_remove_min(struct list_head *head, char *sp, size_t bufsize)
+{
+    return q_remove_prio(head, sp, bufsize, false);
+}
+
+/* Remove the greatest element of queue */
+element_t *q_remove_max(struct list_head *head, char *sp, size_t bufsize)
+{
+    return q_remove_prio(head, sp, bufsize, true);
+}
+
+/* Copy up to @n strings from one end of the queue into @arena, then detach
+ * their elements with one cut and release them in a batch
+ */
+static int q_remove_n(struct list_head *head,
+                      int n,
+                      size_t *out_vec,
+                      const q_arena_t *arena,
+                      bool tail)
+{
+    if (!head || !out_vec || !arena || n <= 0)
+        return 0;
+
+    int cnt = 0;
+    size_t used = 0;
+    struct list_head *node = tail ? head->prev : head->next, *last = head;
+    for (; cnt < n && node != head; node = tail ? node->prev : node->next) {
+        const element_t *element = list_entry(node, element_t, list);
+        size_t len = element->len + 1;
+        if (len > arena->size - used)
+            break;
+        memcpy(arena->buf + used, element->value, len);
+        out_vec[cnt++] = used;
+        used += len;
+        last = node;
+    }
+    if (!cnt)
+        return 0;
+
+    LIST_HEAD(batch);
+    if (tail) {
+        /* Cut off what stays, take the rest, then put what stays back */
+        LIST_HEAD(front);
+        list_cut_position(&front, head, last->prev);
+        list_splice_init(head, &batch);
+        list_splice(&front, head);
+    } else {
+        list_cut_position(&batch, head, last);
+    }
+    skip_invalidate(q_header(head));
+    heap_invalidate(q_header(head));
+    mid_invalidate(q_header(head));
+    qindex_pop(q_header(head), cnt, tail);
+    q_header(head)->size -= cnt;
+
+    q_release_list(&batch);
+    return cnt;
+}
+
+/* Remove many elements from head of queue */
+int q_remove_head_n(struct list_head *head,
+                    int n,
+                    size_t *out_vec,
+                    const q_arena_t *arena)
 {
-    return q_remove(head->prev, sp, bufsize);
+    return q_remove_n(head, n, out_vec, arena, false);
+}
+
+/* Remove many elements from tail of queue */
+int q_remove_tail_n(struct list_head *head,
+                    int n,
+                    size_t *out_vec,
+                    const q_arena_t *arena)
+{
+    return q_remove_n(head, n, out_vec, arena, true);
 }
 
 /* Return number of elements in queue */
@@ -129,13 +505,39 @@ int q_size(struct list_head *head)
 {
     if (!head)
         return 0;
+    return q_header(head)->size;
+}
 
-    int len = 0;
-    struct list_head *li;
+/* Look up a string in queue */
+element_t *q_find(struct list_head *head, char *s)
+{
+    if (!head)
+        return NULL;
+
+    queue_t *q = q_header(head);
+    if (skip_sync(q))
+        return skip_find(q, s);
 
-    list_for_each (li, head)
-        len++;
-    return len;
+    /* Not sorted, or no memory for the index: try every element */
+    element_t *element;
+    list_for_each_entry (element, head, list) {
+        if (!strcmp(element->value, s))
+            return element;
+    }
+    return NULL;
+}
+
+/* The node of the middle element, found again if it went stale */
+static struct list_head *q_mid(queue_t *q)
+{
+    if (!q->mid_valid) {
+        struct list_head *node = q->head.next;
+        for (int i = q->size / 2; i > 0; i--)
+            node = node->next;
+        q->mid = node;
+        q->mid_valid = true;
+    }
+    return q->mid;
 }
 
 /* Delete the middle node in queue */
@@ -144,13 +546,88 @@ bool q_delete_mid(struct list_head *head)
     // https://leetcode.com/problems/delete-the-middle-node-of-a-linked-list/
     if (!head || list_empty(head)) /* input validation */
         return false;
-    struct list_head **indir = &(head->next);
-    const struct list_head *fast = head->next;
-    for (; fast != head && fast->next != head; fast = fast->next->next)
-        indir = &(*indir)->next;
-    element_t *element = list_entry(*indir, element_t, list);
-    list_del(&element->list);
-    q_release_element(element);
+
+    queue_t *q = q_header(head);
+    struct list_head *mid = q_mid(q);
+    if (q->skip_valid)
+        skip_delete_at(q, q->size / 2);
+    qindex_invalidate(q);
+    heap_invalidate(q);
+
+    /* The middle of one element less is the next one for an odd size, the
+     * previous one for an even size
+     */
+    q->mid = q->size & 1 ? mid->next : mid->prev;
+    list_del(mid);
+    q_release_element(list_entry(mid, element_t, list));
+    q->size--;
+    return true;
+}
+
+/* Slot of the open-addressing table used by dedup_hash() */
+struct dedup_slot {
+    element_t *element;
+    uint32_t hash;
+    bool dup;
+};
+
+/* Interned strings come with their hash */
+static inline uint32_t dedup_hash_str(const element_t *element)
+{
+    if (element->value != element->data)
+        return intern_of(element->value)->hash;
+    return q_hash(element->value);
+}
+
+/* Whether two elements hold equal strings. Interned strings are pooled once
+ * each, so that the same pointer settles it without comparing; other strings
+ * differ outright if their keys or lengths do.
+ */
+static inline bool q_element_equal(const element_t *a, const element_t *b)
+{
+    if (a->value == b->value)
+        return true;
+    if (a->key != b->key || a->len != b->len)
+        return false;
+    return a->len <= 8 || !simd_memcmp(a->value + 8, b->value + 8, a->len - 8);
+}
+
+/* Delete every string occurring more than once, in expected linear time */
+static bool dedup_hash(struct list_head *head)
+{
+    size_t cap = 2;
+    while (cap < 2 * (size_t) q_size(head))
+        cap <<= 1;
+
+    struct dedup_slot *table = calloc(cap, sizeof(*table));
+    if (!table)
+        return false;
+
+    /* Keep the first occurrence in the table, delete later ones at once */
+    struct list_head *node, *safe;
+    list_for_each_safe (node, safe, head) {
+        element_t *element = list_entry(node, element_t, list);
+        uint32_t hash = dedup_hash_str(element);
+        size_t i = hash & (cap - 1);
+        for (; table[i].element; i = (i + 1) & (cap - 1)) {
+            if (table[i].hash == hash &&
+                q_element_equal(table[i].element, element))
+                break;
+        }
+        if (table[i].element) {
+            table[i].dup = true;
+            q_delete(head, element);
+        } else {
+            table[i].element = element;
+            table[i].hash = hash;
+        }
+    }
+
+    for (size_t i = 0; i < cap; i++) {
+        if (table[i].dup)
+            q_delete(head, table[i].element);
+    }
+    free(table);
     return true;
 }
 
@@ -163,24 +640,26 @@ bool q_delete_dup(struct list_head *head)
     if (!head || list_empty(head)) /* input validation */
         return false;
 
+    if (q_dedup_mode == DEDUP_HASH)
+        return dedup_hash(head);
+
     bool flag = false;
     element_t *curr_entry = list_first_entry(head, element_t, list);
     element_t *next_entry;
     while (&curr_entry->list != head) {
         next_entry = list_entry(curr_entry->list.next, element_t, list);
         while (&next_entry->list != head &&
-               !strcmp(curr_entry->value, next_entry->value)) {
-            list_del(&next_entry->list);
-            q_release_element(next_entry);
+               q_element_equal(curr_entry, next_entry)) {
+            q_delete(head, next_entry);
             /* update next pointer */
             next_entry = list_entry(curr_entry->list.next, element_t, list);
             flag = true;
         }
         if (flag) { /*need remove current node*/
-            list_del(&curr_entry->list);
-            q_release_element(curr_entry);
+            q_delete(head, curr_entry);
             flag = false;
         }
+        curr_entry = next_entry;
     }
     return true;
 }
@@ -192,6 +671,12 @@ void q_swap(struct list_head *head)
     if (!head)
         return;
 
+    skip_invalidate(q_header(head));
+    mid_invalidate(q_header(head));
+    if (qindex_sync(q_header(head)) &&
+        qindex_reverseK(q_header(head), 2))
+        return;
+    qindex_invalidate(q_header(head));
     struct list_head *first = head->next;
     struct list_head *second = first->next;
     for (; first != head && second != head;
@@ -201,12 +686,31 @@ void q_swap(struct list_head *head)
     }
 }
 
+/* Swap the links of @n nodes starting at @node, following the old next */
+static inline struct list_head *reverse_links(struct list_head *node, int n)
+{
+    for (; n > 0; n--) {
+        struct list_head *next = node->next;
+        node->next = node->prev;
+        node->prev = next;
+        node = next;
+    }
+    return node;
+}
+
 /* Reverse elements in queue */
 void q_reverse(struct list_head *head)
 {
-    struct list_head *current, *safe;
-    list_for_each_safe (current, safe, head)
-        list_move(current, head);
+    if (!head)
+        return;
+    skip_invalidate(q_header(head));
+    mid_invalidate(q_header(head));
+    if (qindex_sync(q_header(head)) &&
+        qindex_reverseK(q_header(head), q_size(head)))
+        return;
+    qindex_invalidate(q_header(head));
+    /* Swapping every link, the head's included, reverses the list */
+    reverse_links(head, q_size(head) + 1);
 }
 
 /* Reverse the nodes of the list k at a time */
@@ -215,64 +719,185 @@ void q_reverseK(struct list_head *head, int k)
     // https://leetcode.com/problems/reverse-nodes-in-k-group/
     if (!head || head->next == head || k <= 1)
         return;
-    size_t cnt = 0;
-    struct list_head *curr = NULL, *safe = NULL, *start = head;
-    list_for_each_safe (curr, safe, head) {
-        cnt++;
-        if (cnt == k) {
-            LIST_HEAD(tmp);
-            cnt = 0;
-
-            list_cut_position(&tmp, start, curr);
-            q_reverse(&tmp);
-            list_splice(&tmp, start);
-
-            start = safe->prev;
+
+    skip_invalidate(q_header(head));
+    mid_invalidate(q_header(head));
+    if (qindex_sync(q_header(head)) &&
+        qindex_reverseK(q_header(head), k))
+        return;
+    qindex_invalidate(q_header(head));
+    struct list_head *before = head;
+    for (int left = q_size(head); left >= k; left -= k) {
+        struct list_head *first = before->next;
+        struct list_head *after = reverse_links(first, k);
+        struct list_head *last = after->prev;
+
+        /* Only the links leaving the group still point the old way */
+        first->next = after;
+        after->prev = first;
+        before->next = last;
+        last->prev = before;
+        before = first;
+    }
+}
+
+/* Order elements by their strings, @priv points to the descend flag */
+static int q_cmp(void *priv,
+                 const struct list_head *a,
+                 const struct list_head *b)
+{
+    int ret = q_element_cmp(list_entry(a, element_t, list),
+                            list_entry(b, element_t, list));
+    return *(bool *) priv ? -ret : ret;
+}
+
+/* Buckets smaller than this are finished with an insertion sort */
+#define RADIX_CUTOFF 16
+
+/* Compare the strings of two elements from byte @depth on */
+static inline int radix_cmp(const struct list_head *a,
+                            const struct list_head *b,
+                            size_t depth,
+                            bool descend)
+{
+    const element_t *x = list_entry(a, element_t, list);
+    const element_t *y = list_entry(b, element_t, list);
+    size_t len = x->len < y->len ? x->len : y->len;
+    int ret = simd_memcmp(x->value + depth, y->value + depth, len - depth + 1);
+    return descend ? -ret : ret;
+}
+
+/* Stable insertion sort of elements sharing their first @depth bytes */
+static void radix_insertion_sort(struct list_head *head,
+                                 size_t depth,
+                                 bool descend)
+{
+    struct list_head *node, *safe;
+
+    list_for_each_safe (node, safe, head) {
+        struct list_head *pos = node->prev;
+        while (pos != head && radix_cmp(pos, node, depth, descend) > 0)
+            pos = pos->prev;
+        if (pos != node->prev)
+            list_move(node, pos);
+    }
+}
+
+/* Stable MSD radix sort of the @n elements of @head, which share their first
+ * @depth bytes.
+ *
+ * Elements are distributed into one bucket per byte value, in list order.
+ * Every bucket but the largest is sorted recursively and set aside on the
+ * proper side of it; the largest one is carried into the next iteration. Each
+ * recursive call thus handles at most half of the elements, which bounds the
+ * recursion depth by log2(n) whatever the length of the strings, and only
+ * list heads on the stack are needed, so the sort does not allocate.
+ */
+static void radix_sort(struct list_head *head,
+                       size_t n,
+                       size_t depth,
+                       bool descend)
+{
+    LIST_HEAD(before);
+    LIST_HEAD(after);
+
+    while (n >= RADIX_CUTOFF) {
+        struct list_head buckets[256];
+        size_t counts[256] = {0};
+        int largest = 1;
+
+        for (int c = 0; c < 256; c++)
+            INIT_LIST_HEAD(&buckets[c]);
+        while (!list_empty(head)) {
+            struct list_head *node = head->next;
+            unsigned char c = list_entry(node, element_t, list)->value[depth];
+            list_move_tail(node, &buckets[c]);
+            counts[c]++;
+        }
+
+        /* Bucket 0 holds strings ending here: they are equal and final */
+        for (int c = 2; c < 256; c++) {
+            if (counts[c] > counts[largest])
+                largest = c;
+        }
+
+        LIST_HEAD(tail);
+        bool passed = false;
+        for (int i = 0; i < 256; i++) {
+            int c = descend ? 255 - i : i;
+            if (c == largest) {
+                passed = true;
+                continue;
+            }
+            if (c && counts[c] > 1)
+                radix_sort(&buckets[c], counts[c], depth + 1, descend);
+            list_splice_tail(&buckets[c], passed ? &tail : &before);
         }
+        list_splice(&tail, &after);
+
+        list_splice(&buckets[largest], head);
+        n = counts[largest];
+        depth++;
     }
+
+    if (n > 1)
+        radix_insertion_sort(head, depth, descend);
+    list_splice(&before, head);
+    list_splice_tail(&after, head);
 }
 
 /* Sort elements of queue in ascending/descending order */
 void q_sort(struct list_head *head, bool descend)
 {
-    if (!head || head->next == head || head->prev == head->next)
+    if (!head)
         return;
-    struct list_head *slow = head;
-    const struct list_head *fast = head->next;
-    for (; fast != head && fast->next != head; fast = fast->next->next)
-        slow = slow->next;
-    struct list_head left;
-    list_cut_position(&left, head, slow);
-    q_sort(&left, descend);
-    q_sort(head, descend);
-    q_merge_two(head, &left, descend);
-}
-
-void q_merge_two(struct list_head *first,
-                 struct list_head *second,
-                 bool descend)
-{
-    if (!first || !second)
+
+    skip_invalidate(q_header(head));
+    mid_invalidate(q_header(head));
+#ifdef QINDEX_RING
+    if (q_sort_mode == SORT_MERGE && q_sort_threads <= 1 &&
+        qindex_sync(q_header(head)) &&
+        qindex_sort(q_header(head), descend))
         return;
+#endif
+    qindex_invalidate(q_header(head));
+    switch (q_sort_mode) {
+    case SORT_TIMSORT:
+        list_timsort(&descend, head, q_cmp);
+        break;
+    case SORT_RADIX:
+        radix_sort(head, q_size(head), 0, descend);
+        break;
+    default:
+        list_psort(&descend, head, q_cmp, q_size(head), q_sort_threads);
+        break;
+    }
+}
+
+/* Walk the queue from right to left, keeping track of the best element seen
+ * so far, and delete every element that compares greater than it (@sign 1)
+ * or less than it (@sign -1).
+ */
+static int q_drop_dominated(struct list_head *head, int sign)
+{
+    if (!head)
+        return 0;
+    if (list_empty(head))
+        return q_size(head);
+
+    element_t *best = list_last_entry(head, element_t, list);
+    struct list_head *node, *prev;
 
-    struct list_head tmp;
-    INIT_LIST_HEAD(&tmp);
-    while (!list_empty(first) && !list_empty(second)) {
-        element_t *first_top = list_first_entry(first, element_t, list);
-        element_t *second_top = list_first_entry(second, element_t, list);
-        const char *first_str = first_top->value,
-                   *second_str = second_top->value;
-        bool check;
-        if (descend)
-            check = strcmp(first_str, second_str) > 0;
+    for (node = best->list.prev; node != head; node = prev) {
+        element_t *curr = list_entry(node, element_t, list);
+
+        prev = node->prev;
+        if (q_element_cmp(curr, best) * sign > 0)
+            q_delete(head, curr);
         else
-            check = strcmp(first_str, second_str) < 0;
-        element_t *add_first = check ? first_top : second_top;
-        list_move_tail(&add_first->list, &tmp);
+            best = curr;
     }
-    list_splice_tail_init(first, &tmp);
-    list_splice_tail_init(second, &tmp);
-    list_splice(&tmp, first);
+    return q_size(head);
 }
 
 /* Remove every node which has a node with a strictly less value anywhere to
@@ -280,33 +905,7 @@ void q_merge_two(struct list_head *first,
 int q_ascend(struct list_head *head)
 {
     // https://leetcode.com/problems/remove-nodes-from-linked-list/
-    element_t *curr = NULL, *prev = NULL;
-    const element_t *target;
-    struct list_head *pos = NULL;
-
-    if (!head || list_empty(head) || list_is_singular(head))
-        return 0;
-
-    list_for_each_entry (curr, head, list) {
-        /* Release the element in the next round */
-        if (prev) {
-            q_release_element(prev);
-            prev = NULL;
-        }
-
-        /* check right side and find if there is greater value */
-        if (curr->list.next)
-            pos = curr->list.next;
-        for (; pos != head; pos = pos->next) {
-            target = list_entry(pos, element_t, list);
-            if (strcmp(curr->value, target->value) > 0) {
-                list_del(&curr->list);
-                prev = curr;
-                break;
-            }
-        }
-    }
-    return q_size(head);
+    return q_drop_dominated(head, 1);
 }
 
 /* Remove every node which has a node with a strictly greater value anywhere to
@@ -314,35 +913,83 @@ int q_ascend(struct list_head *head)
 int q_descend(struct list_head *head)
 {
     // https://leetcode.com/problems/remove-nodes-from-linked-list/
-    element_t *curr = NULL, *prev = NULL;
-    const element_t *target;
-    struct list_head *pos = NULL;
+    return q_drop_dominated(head, -1);
+}
 
-    if (!head || list_empty(head) || list_is_singular(head))
-        return 0;
+/* Most queues merged in one pass, bounding the stack used by q_merge() */
+#define MERGE_FANIN 1024
 
-    list_for_each_entry (curr, head, list) {
-        /* Release the element in the next round */
-        if (prev) {
-            q_release_element(prev);
-            prev = NULL;
-        }
+/* Tournament (loser) tree over the heads of up to MERGE_FANIN sorted queues.
+ * tree[0] holds the index of the queue whose head comes next, tree[1..k-1]
+ * the losers of the matches played at each internal node.
+ */
+struct tournament {
+    struct list_head *src[MERGE_FANIN];
+    int tree[MERGE_FANIN];
+    int k;
+    bool descend;
+};
 
+/* Whether the head of queue @i comes before the head of queue @j; exhausted
+ * queues lose every match and ties go to the queue earlier in the chain
+ */
+static inline bool beats(const struct tournament *t, int i, int j)
+{
+    if (list_empty(t->src[j]))
+        return !list_empty(t->src[i]);
+    if (list_empty(t->src[i]))
+        return false;
 
-        /* check right side and find if there is greater value */
-        if (curr->list.next)
-            pos = curr->list.next;
-        for (; pos != head; pos = pos->next) {
-            target = list_entry(pos, element_t, list);
-            if (strcmp(curr->value, target->value) < 0) {
-                list_del(&curr->list);
-                prev = curr;
-                break;
-            }
+    int ret = q_element_cmp(list_first_entry(t->src[i], element_t, list),
+                            list_first_entry(t->src[j], element_t, list));
+    if (t->descend)
+        ret = -ret;
+    return ret < 0 || (!ret && i < j);
+}
+
+/* Replay the matches from the leaf of queue @s up to the root */
+static void tournament_adjust(struct tournament *t, int s)
+{
+    int winner = s;
+
+    for (int node = (s + t->k) / 2; node > 0; node /= 2) {
+        /* While the tree is built, -1 stands for a queue not seen yet; it
+         * wins every match so that real queues settle as losers below it.
+         */
+        if (winner == -1)
+            continue;
+        if (t->tree[node] == -1 || beats(t, t->tree[node], winner)) {
+            int loser = winner;
+            winner = t->tree[node];
+            t->tree[node] = loser;
         }
     }
+    t->tree[0] = winner;
+}
 
-    return q_size(head);
+/* Merge the t->k sorted queues of @t into the first one */
+static void tournament_merge(struct tournament *t)
+{
+    LIST_HEAD(out);
+    int size = 0;
+
+    for (int i = 0; i < t->k; i++) {
+        t->tree[i] = -1;
+        size += q_header(t->src[i])->size;
+        q_header(t->src[i])->size = 0;
+        q_invalidate(q_header(t->src[i]));
+    }
+    for (int i = t->k - 1; i >= 0; i--)
+        tournament_adjust(t, i);
+
+    while (!list_empty(t->src[t->tree[0]])) {
+        int w = t->tree[0];
+        list_move_tail(t->src[w]->next, &out);
+        tournament_adjust(t, w);
+    }
+
+    list_splice(&out, t->src[0]);
+    q_header(t->src[0])->size = size;
 }
 
 /* Merge all the queues into one sorted queue, which is in ascending/descending
@@ -352,20 +999,36 @@ int q_merge(struct list_head *head, bool descend)
     // https://leetcode.com/problems/merge-k-sorted-lists/
     if (!head || list_empty(head))
         return 0;
-    if (list_is_singular(head))
-        return q_size(list_first_entry(head, queue_contex_t, chain)->q);
 
-    queue_contex_t *first, *target = NULL;
-    first = list_first_entry(head, queue_contex_t, chain);
+    queue_contex_t *first = list_first_entry(head, queue_contex_t, chain);
+    struct tournament t = {.descend = descend};
+    size_t k = 0;
+    struct list_head *pos;
 
-    /* move each target's queue to first context's queue */
-    list_for_each_entry (target, head->next, chain) {
-        if (target->id == first->id)
-            break;
-        list_splice_tail_init(target->q, first->q);
+    list_for_each (pos, head)
+        k++;
+
+    /* Each pass merges groups of up to MERGE_FANIN consecutive queues into
+     * the first queue of the group; with fewer queues than that, a single
+     * pass moves every element exactly once, at the cost of log2(k)
+     * comparisons. Queues that take part in a pass are @stride apart in the
+     * chain, the others having been emptied by earlier passes.
+     */
+    for (size_t stride = 1; stride < k; stride *= MERGE_FANIN) {
+        pos = head->next;
+        while (pos != head) {
+            t.k = 0;
+            while (pos != head && t.k < MERGE_FANIN) {
+                queue_contex_t *ctx = list_entry(pos, queue_contex_t, chain);
+                if (ctx->q)
+                    t.src[t.k++] = ctx->q;
+                for (size_t j = 0; j < stride && pos != head; j++)
+                    pos = pos->next;
+            }
+            if (t.k > 1)
+                tournament_merge(&t);
+        }
     }
-    q_sort(first->q, descend);
-    head = first->q;
 
-    return q_size(head);
+    return q_size(first->q);
 }
@@ -9,22 +9,166 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "harness.h"
+#include "intern.h"
 #include "list.h"
+#include "simdcmp.h"
+
+/**
+ * q_chunk_t - Allocation shared by the elements of a bulk insert
+ * @refs: the number of its elements not released yet
+ */
+typedef struct {
+    size_t refs;
+} q_chunk_t;
 
 /**
  * element_t - Linked list element
  * @value: pointer to array holding string
  * @list: node of a doubly-linked list
- *
- * @value needs to be explicitly allocated and freed
+ * @key: first bytes of the string, see q_key()
+ * @len: length of the string, terminator excluded
+ * @chunk: allocation holding the element, %NULL if it has its own
+ * @data: inline storage for the string
+ *
+ * The element and its string are carved out of a single allocation: @value
+ * points at @data, which extends past the end of the structure by the length
+ * of the string plus its null terminator. Releasing the element therefore
+ * releases the string as well. Elements made by q_insert_head_bulk() and
+ * q_insert_tail_bulk() share one chunk, which goes away with the last of them.
+ *
+ * Elements inserted while q_intern_strings is set have no @data: @value
+ * points into the intern pool instead, see intern.h, and the element holds a
+ * reference on it.
  */
 typedef struct {
     char *value;
     struct list_head list;
+    uint64_t key;
+    size_t len;
+    q_chunk_t *chunk;
+    char data[];
 } element_t;
 
+/**
+ * q_key() - Compute the comparison key cached in element_t
+ * @s: string of the element
+ *
+ * Return: the first 8 bytes of @s as a big-endian integer, padded with zero
+ * bytes past the end of the string. Keys order like the strings they come
+ * from, as far as those 8 bytes go.
+ */
+static inline uint64_t q_key(const char *s)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) {
+        key <<= 8;
+        if (*s)
+            key |= (unsigned char) *s++;
+    }
+    return key;
+}
+
+/**
+ * q_element_cmp() - Compare the strings of two elements
+ * @a: first element
+ * @b: second element
+ *
+ * Most pairs are told apart by their cached keys alone; the strings are only
+ * read when their first 8 bytes are equal, and then compared with
+ * simd_memcmp() up to the terminator of the shorter one.
+ *
+ * Return: an integer less than, equal to, or greater than zero, as strcmp()
+ */
+static inline int q_element_cmp(const element_t *a, const element_t *b)
+{
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+    /* The strings end within the key, so they are equal */
+    if (!(a->key & 0xff))
+        return 0;
+    size_t len = a->len < b->len ? a->len : b->len;
+    return simd_memcmp(a->value + 8, b->value + 8, len - 8 + 1);
+}
+
+/**
+ * q_hash() - Hash a string, FNV-1a over all of its bytes
+ * @s: the string
+ *
+ * Return: the hash
+ */
+static inline uint32_t q_hash(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s)
+        h = (h ^ (unsigned char) *s++) * 16777619u;
+    return h;
+}
+
+#if defined(QINDEX_RING) || defined(QINDEX_UNROLLED)
+#define QINDEX
+#endif
+
+struct skiplist;
+struct pairheap;
+
+/**
+ * queue_t - Header of a queue created by q_new()
+ * @head: head of the circular doubly-linked list of elements
+ * @size: the number of elements linked on @head
+ * @ring: circular array of the elements, ring index only
+ * @cap: the number of slots of @ring, a power of two
+ * @first: slot of the element at the head of the queue
+ * @chunks: list of the arrays of elements, unrolled index only
+ * @spare: list of the arrays not in use, unrolled index only
+ * @nchunks: the number of arrays on @chunks and @spare
+ * @index_valid: whether the index mirrors the list
+ * @skip: skip-list index of a sorted queue, see skiplist.h, %NULL if unused
+ * @skip_valid: whether @skip mirrors the list
+ * @heap: pairing heap of the elements, see pairheap.h, %NULL if unused
+ * @heap_valid: whether @heap holds exactly the elements on the list
+ * @mid: node of the middle element, @head if the queue is empty
+ * @mid_valid: whether @mid is up to date
+ *
+ * q_new() hands out &q->head, so callers keep treating a queue as a plain
+ * struct list_head while the queue operations recover the header through
+ * container_of(). @size is kept up to date by every operation that links or
+ * unlinks elements, which makes q_size() constant time. The fields from
+ * @ring to @index_valid belong to the index selected at build time, see
+ * qindex.h.
+ *
+ * The middle element is the (@size / 2)-th one. Inserting or removing a
+ * single element at either end moves it by one node at most, depending on
+ * the parity of @size, which those operations follow to keep @mid up to
+ * date, as does q_delete_mid(). Every other operation marks it stale, and
+ * the next q_delete_mid() finds it again.
+ */
+typedef struct {
+    struct list_head head;
+    int size;
+#if defined(QINDEX_RING)
+    element_t **ring;
+    size_t cap;
+    size_t first;
+#elif defined(QINDEX_UNROLLED)
+    struct list_head chunks;
+    struct list_head spare;
+    size_t nchunks;
+#endif
+#ifdef QINDEX
+    bool index_valid;
+#endif
+    struct skiplist *skip;
+    bool skip_valid;
+    struct pairheap *heap;
+    bool heap_valid;
+    struct list_head *mid;
+    bool mid_valid;
+} queue_t;
+
 /**
  * queue_contex_t - The context managing a chain of queues
  * @q: pointer to the head of the queue
@@ -39,6 +183,50 @@ typedef struct {
     int id;
 } queue_contex_t;
 
+/**
+ * sort_mode_t - Algorithms q_sort() can dispatch to
+ * @SORT_MERGE: bottom-up merge sort, see list_sort(), possibly parallel
+ * @SORT_TIMSORT: natural-run merge sort, see list_timsort()
+ * @SORT_RADIX: MSD radix sort on the bytes of the strings
+ */
+typedef enum {
+    SORT_MERGE,
+    SORT_TIMSORT,
+    SORT_RADIX,
+} sort_mode_t;
+
+/* Algorithm used by q_sort(), one of sort_mode_t */
+extern int q_sort_mode;
+
+/* Threads a SORT_MERGE q_sort() is spread over, see list_psort() */
+extern int q_sort_threads;
+
+/**
+ * dedup_mode_t - Strategies q_delete_dup() can dispatch to
+ * @DEDUP_ADJACENT: drop runs of equal neighbours, queue must be sorted
+ * @DEDUP_HASH: drop every string seen twice anywhere, via a hash table
+ */
+typedef enum {
+    DEDUP_ADJACENT,
+    DEDUP_HASH,
+} dedup_mode_t;
+
+/* Strategy used by q_delete_dup(), one of dedup_mode_t */
+extern int q_dedup_mode;
+
+/* Whether inserted strings are shared through the intern pool, see intern.h */
+extern int q_intern_strings;
+
+/**
+ * q_arena_t - Caller-provided buffer removed strings are packed into
+ * @buf: start of the buffer
+ * @size: the number of bytes at @buf
+ */
+typedef struct {
+    char *buf;
+    size_t size;
+} q_arena_t;
+
 /* Operations on queue */
 
 /**
@@ -78,6 +266,64 @@ bool q_insert_head(struct list_head *head, char *s);
  */
 bool q_insert_tail(struct list_head *head, char *s);
 
+/**
+ * q_insert_head_bulk() - Insert many elements at head of queue
+ * @head: header of queue
+ * @sv: strings would be inserted
+ * @n: the number of strings in @sv
+ *
+ * Same as calling q_insert_head() on @sv[0] to @sv[n - 1] in turn, so the
+ * queue starts with @sv[n - 1]. All the elements are carved out of a single
+ * allocation and spliced onto the queue at once.
+ *
+ * Return: true for success, false for allocation failed or queue is NULL.
+ * Nothing is inserted on failure.
+ */
+bool q_insert_head_bulk(struct list_head *head, char **sv, int n);
+
+/**
+ * q_insert_tail_bulk() - Insert many elements at tail of queue
+ * @head: header of queue
+ * @sv: strings would be inserted
+ * @n: the number of strings in @sv
+ *
+ * Same as calling q_insert_tail() on @sv[0] to @sv[n - 1] in turn.
+ *
+ * Return: true for success, false for allocation failed or queue is NULL.
+ * Nothing is inserted on failure.
+ */
+bool q_insert_tail_bulk(struct list_head *head, char **sv, int n);
+
+/**
+ * q_insert_sorted() - Insert an element into a queue in ascending order
+ * @head: header of queue
+ * @s: string would be inserted
+ *
+ * The element goes after every element whose string compares less than or
+ * equal to @s, so the queue stays sorted. Takes expected O(log n) time
+ * through a skip-list index, built on the first call after the queue was
+ * last changed by anything but q_insert_sorted(), q_remove_head(),
+ * q_remove_tail() and q_delete_mid().
+ *
+ * Return: true for success, false for allocation failed, queue is NULL or
+ * not sorted in ascending order
+ */
+bool q_insert_sorted(struct list_head *head, char *s);
+
+/**
+ * q_insert_prio() - Insert an element into the priority heap of queue
+ * @head: header of queue
+ * @s: string would be inserted
+ *
+ * The element goes at the tail of the queue, as with q_insert_tail(), and
+ * into the pairing heap behind q_remove_min() and q_remove_max(), in O(1)
+ * amortized time. The heap is built on the first call to either of those
+ * after the queue last gained or lost elements by any other operation.
+ *
+ * Return: true for success, false for allocation failed or queue is NULL
+ */
+bool q_insert_prio(struct list_head *head, char *s);
+
 /**
  * q_remove_head() - Remove the element from head of queue
  * @head: header of queue
@@ -108,6 +354,69 @@ element_t *q_remove_head(struct list_head *head, char *sp, size_t bufsize);
  */
 element_t *q_remove_tail(struct list_head *head, char *sp, size_t bufsize);
 
+/**
+ * q_remove_min() - Remove the element whose string compares least
+ * @head: header of queue
+ * @sp: string would be inserted
+ * @bufsize: size of the string
+ *
+ * Takes O(log n) amortized time through the pairing heap of
+ * q_insert_prio(). Between equal strings, any one may be removed. Asking
+ * for the least element after the greatest, or the other way round,
+ * rebuilds the heap.
+ *
+ * Return: the pointer to element, %NULL if queue is NULL or empty.
+ */
+element_t *q_remove_min(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * q_remove_max() - Remove the element whose string compares greatest
+ * @head: header of queue
+ * @sp: string would be inserted
+ * @bufsize: size of the string
+ *
+ * Same as q_remove_min(), in descending order.
+ *
+ * Return: the pointer to element, %NULL if queue is NULL or empty.
+ */
+element_t *q_remove_max(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * q_remove_head_n() - Remove many elements from head of queue
+ * @head: header of queue
+ * @n: the maximum number of elements to remove
+ * @out_vec: receives the offset in @arena of each removed string
+ * @arena: buffer the removed strings are copied into, back to back
+ *
+ * The strings are copied whole, null terminators included, in the order the
+ * elements are removed. Removal stops early at the first string that would
+ * not fit in what is left of @arena. The removed elements are detached with a
+ * single cut and, unlike with q_remove_head(), released before returning, a
+ * run of elements from the same bulk insertion dropping its chunk at once.
+ *
+ * Return: the number of elements removed, 0 if queue is NULL or empty
+ */
+int q_remove_head_n(struct list_head *head,
+                    int n,
+                    size_t *out_vec,
+                    const q_arena_t *arena);
+
+/**
+ * q_remove_tail_n() - Remove many elements from tail of queue
+ * @head: header of queue
+ * @n: the maximum number of elements to remove
+ * @out_vec: receives the offset in @arena of each removed string
+ * @arena: buffer the removed strings are copied into, back to back
+ *
+ * Same as q_remove_head_n(), starting with the last element.
+ *
+ * Return: the number of elements removed, 0 if queue is NULL or empty
+ */
+int q_remove_tail_n(struct list_head *head,
+                    int n,
+                    size_t *out_vec,
+                    const q_arena_t *arena);
+
 /**
  * q_release_element() - Release the element
  * @e: element would be released
@@ -116,8 +425,12 @@ element_t *q_remove_tail(struct list_head *head, char *sp, size_t bufsize);
  */
 static inline void q_release_element(element_t *e)
 {
-    test_free(e->value);
-    test_free(e);
+    if (e->value != e->data)
+        intern_put(e->value);
+    if (!e->chunk)
+        test_free(e);
+    else if (!--e->chunk->refs)
+        test_free(e->chunk);
 }
 
 /**
@@ -128,6 +441,19 @@ static inline void q_release_element(element_t *e)
  */
 int q_size(struct list_head *head);
 
+/**
+ * q_find() - Look up a string in queue
+ * @head: header of queue
+ * @s: string to look for
+ *
+ * A queue sorted in ascending order is searched in expected O(log n) time
+ * through the index of q_insert_sorted(), any other queue element by element.
+ *
+ * Return: the first element holding @s, %NULL if queue is NULL or there is
+ * none
+ */
+element_t *q_find(struct list_head *head, char *s);
+
 /**
  * q_delete_mid() - Delete the middle node in queue
  * @head: header of queue
@@ -136,6 +462,9 @@ int q_size(struct list_head *head);
  * ⌊n / 2⌋th node from the start using 0-based indexing.
  * If there're six elements, the third member should be returned.
  *
+ * Takes O(1) time through the middle node tracked in queue_t, found again
+ * in O(n) after the queue was reordered or changed other than at its ends.
+ *
  * Reference:
  * https://leetcode.com/problems/delete-the-middle-node-of-a-linked-list/
  *
@@ -148,10 +477,14 @@ bool q_delete_mid(struct list_head *head);
  *                  leaving only distinct strings from the original queue.
  * @head: header of queue
  *
+ * With q_dedup_mode set to DEDUP_HASH the queue needs not be sorted:
+ * duplicates are found anywhere and the survivors keep their order.
+ *
  * Reference:
  * https://leetcode.com/problems/remove-duplicates-from-sorted-list-ii/
  *
- * Return: true for success, false if list is NULL or empty.
+ * Return: true for success, false if list is NULL or empty, or if the
+ * hash table could not be allocated.
  */
 bool q_delete_dup(struct list_head *head);
 
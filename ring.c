@@ -0,0 +1,175 @@
+/* Ring-buffer index, see qindex.h: the elements of a queue in queue order,
+ * in a power-of-two circular array
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "qindex.h"
+
+/* Slots allocated for the first element */
+#define RING_MIN 8
+
+/* The slot of the @i-th element from the head */
+static inline element_t **ring_slot(const queue_t *q, size_t i)
+{
+    return &q->ring[(q->first + i) & (q->cap - 1)];
+}
+
+void qindex_init(queue_t *q)
+{
+    q->ring = NULL;
+    q->cap = 0;
+    q->first = 0;
+    q->index_valid = true;
+}
+
+void qindex_free(queue_t *q)
+{
+    free(q->ring);
+    qindex_init(q);
+}
+
+/* Allocate @cap slots for the ring, plus as many for qindex_sort() to merge
+ * into
+ */
+static element_t **ring_alloc(size_t cap)
+{
+    return malloc(2 * cap * sizeof(element_t *));
+}
+
+/* Move the elements into a new array of @cap slots, starting at slot 0 */
+static bool ring_grow(queue_t *q, size_t cap)
+{
+    element_t **ring = ring_alloc(cap);
+    if (!ring)
+        return false;
+    for (size_t i = 0; i < (size_t) q->size; i++)
+        ring[i] = *ring_slot(q, i);
+    free(q->ring);
+    q->ring = ring;
+    q->cap = cap;
+    q->first = 0;
+    return true;
+}
+
+bool qindex_sync(queue_t *q)
+{
+    if (q->index_valid)
+        return true;
+    if (q->cap < (size_t) q->size)
+        return false;
+
+    size_t i = 0;
+    element_t *element;
+    list_for_each_entry (element, &q->head, list)
+        q->ring[i++] = element;
+    q->first = 0;
+    q->index_valid = true;
+    return true;
+}
+
+void qindex_reserve(queue_t *q, size_t n)
+{
+    if (q->index_valid || q->cap >= n)
+        return;
+
+    /* The stale contents need not be moved */
+    size_t cap = q->cap ? q->cap : RING_MIN;
+    while (cap < n)
+        cap <<= 1;
+    element_t **ring = ring_alloc(cap);
+    if (!ring)
+        return;
+    free(q->ring);
+    q->ring = ring;
+    q->cap = cap;
+}
+
+void qindex_push(queue_t *q, element_t *e, bool tail)
+{
+    if (!q->index_valid) {
+        qindex_reserve(q, q->size + 1);
+        return;
+    }
+    /* Failing to grow only costs a rebuild later on */
+    if ((size_t) q->size == q->cap &&
+        !ring_grow(q, q->cap ? 2 * q->cap : RING_MIN)) {
+        qindex_invalidate(q);
+        return;
+    }
+
+    if (tail) {
+        *ring_slot(q, q->size) = e;
+    } else {
+        q->first = (q->first - 1) & (q->cap - 1);
+        q->ring[q->first] = e;
+    }
+}
+
+void qindex_pop(queue_t *q, size_t n, bool tail)
+{
+    if (q->index_valid && !tail)
+        q->first = (q->first + n) & (q->cap - 1);
+}
+
+/* Rewrite the links of the list to follow the array */
+static void ring_relink(queue_t *q)
+{
+    struct list_head *prev = &q->head;
+    for (size_t i = 0; i < (size_t) q->size; i++) {
+        struct list_head *node = &(*ring_slot(q, i))->list;
+        prev->next = node;
+        node->prev = prev;
+        prev = node;
+    }
+    prev->next = &q->head;
+    q->head.prev = prev;
+}
+
+bool qindex_sort(queue_t *q, bool descend)
+{
+    size_t n = q->size;
+    element_t **src = q->ring + q->cap, **dst = q->ring;
+
+    /* Unwrap into the scratch half, then merge runs back and forth */
+    for (size_t i = 0; i < n; i++)
+        src[i] = *ring_slot(q, i);
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = mid + width < n ? mid + width : n;
+            size_t l = lo, r = mid, k = lo;
+            while (l < mid && r < hi) {
+                int cmp = q_element_cmp(src[l], src[r]);
+                dst[k++] = (descend ? -cmp : cmp) <= 0 ? src[l++] : src[r++];
+            }
+            while (l < mid)
+                dst[k++] = src[l++];
+            while (r < hi)
+                dst[k++] = src[r++];
+        }
+        element_t **tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != q->ring)
+        memcpy(q->ring, src, n * sizeof(*src));
+    q->first = 0;
+    ring_relink(q);
+    return true;
+}
+
+bool qindex_reverseK(queue_t *q, size_t k)
+{
+    size_t n = q->size;
+    for (size_t lo = 0; lo + k <= n && k > 1; lo += k) {
+        for (size_t i = lo, j = lo + k - 1; i < j; i++, j--) {
+            element_t *tmp = *ring_slot(q, i);
+            *ring_slot(q, i) = *ring_slot(q, j);
+            *ring_slot(q, j) = tmp;
+        }
+    }
+    ring_relink(q);
+    return true;
+}
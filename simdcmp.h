@@ -0,0 +1,89 @@
+#ifndef LAB0_SIMDCMP_H
+#define LAB0_SIMDCMP_H
+
+/* Comparison of byte strings of known length, behind q_element_cmp().
+ *
+ * The bytes are compared 32 at a time with AVX2 when the compiler targets it
+ * ("make AVX2=1"), 16 at a time with SSE2, which every x86-64 compiler does,
+ * and 8 at a time otherwise. Loads never go past the @n bytes given, so the
+ * strings need no padding.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * simd_mismatch() - Find the first byte where two buffers differ
+ * @a: first buffer
+ * @b: second buffer
+ * @n: the number of bytes to compare
+ *
+ * Return: the offset of the first differing byte, @n if there is none
+ */
+static inline size_t simd_mismatch(const char *a, const char *b, size_t n)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        uint32_t ne = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+        if (ne)
+            return i + __builtin_ctz(ne);
+    }
+#endif
+#if defined(__SSE2__)
+    /* Two vectors per test of the mask while there is room for them */
+    for (; i + 32 <= n; i += 32) {
+        __m128i x0 = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y0 = _mm_loadu_si128((const __m128i *) (b + i));
+        __m128i x1 = _mm_loadu_si128((const __m128i *) (a + i + 16));
+        __m128i y1 = _mm_loadu_si128((const __m128i *) (b + i + 16));
+        __m128i eq =
+            _mm_and_si128(_mm_cmpeq_epi8(x0, y0), _mm_cmpeq_epi8(x1, y1));
+        if (_mm_movemask_epi8(eq) != 0xffff)
+            break;
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        uint32_t ne = ~_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xffff;
+        if (ne)
+            return i + __builtin_ctz(ne);
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if (x != y)
+            break;
+    }
+    /* At most one word left, or the word where they differ */
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+/**
+ * simd_memcmp() - Compare two buffers as unsigned bytes
+ * @a: first buffer
+ * @b: second buffer
+ * @n: the number of bytes to compare
+ *
+ * Return: an integer less than, equal to, or greater than zero, as memcmp()
+ */
+static inline int simd_memcmp(const char *a, const char *b, size_t n)
+{
+    size_t i = simd_mismatch(a, b, n);
+    if (i == n)
+        return 0;
+    return (unsigned char) a[i] - (unsigned char) b[i];
+}
+
+#endif /* LAB0_SIMDCMP_H */
@@ -0,0 +1,260 @@
+/* Skip-list index over a sorted queue, see skiplist.h */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "skiplist.h"
+
+/* Levels of towers above the list. Each level keeps one in 1 << SKIP_BITS
+ * towers of the level below, so that a 32-bit random number decides them all.
+ */
+#define SKIP_LEVELS 16
+#define SKIP_BITS 2
+
+/* Link of a tower, @span elements down the queue. The last link of a level
+ * has no @next and spans up to the position past the tail.
+ */
+struct skiplink {
+    struct skipnode *next;
+    size_t span;
+};
+
+/* Tower over element @e, with as many links as it has levels */
+struct skipnode {
+    element_t *e;
+    struct skiplink link[];
+};
+
+struct skiplist {
+    uint32_t seed;
+    struct skiplink head[SKIP_LEVELS];
+};
+
+/* Where a search stands: a tower, or the header before the first element */
+struct skippos {
+    struct skiplink *link;
+    element_t *e;
+    size_t rank; /* 1 for the first element, 0 for the header */
+};
+
+/* Compare element @e with the string @s whose key is @key, as strcmp() */
+static inline int skip_cmp(const element_t *e, uint64_t key, const char *s)
+{
+    if (e->key != key)
+        return e->key < key ? -1 : 1;
+    if (!(key & 0xff))
+        return 0;
+    return strcmp(e->value + 8, s + 8);
+}
+
+/* Number of levels of a new tower, 0 for none */
+static int skip_height(struct skiplist *sl)
+{
+    /* xorshift32 */
+    uint32_t x = sl->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sl->seed = x;
+
+    int h = 0;
+    for (; h < SKIP_LEVELS && !(x & ((1 << SKIP_BITS) - 1)); x >>= SKIP_BITS)
+        h++;
+    return h;
+}
+
+/* Every tower has a link on the lowest level, so walking it frees them all */
+static void skip_free_towers(struct skiplist *sl)
+{
+    struct skipnode *node = sl->head[0].next;
+    while (node) {
+        struct skipnode *next = node->link[0].next;
+        free(node);
+        node = next;
+    }
+}
+
+void skip_free(queue_t *q)
+{
+    if (q->skip) {
+        skip_free_towers(q->skip);
+        free(q->skip);
+    }
+    q->skip = NULL;
+    q->skip_valid = false;
+}
+
+bool skip_sync(queue_t *q)
+{
+    if (q->skip_valid)
+        return true;
+
+    struct skiplist *sl = q->skip;
+    if (sl) {
+        skip_free_towers(sl);
+    } else {
+        sl = malloc(sizeof(*sl));
+        if (!sl)
+            return false;
+        sl->seed = 2463534242;
+        q->skip = sl;
+    }
+
+    /* Append the towers level by level, checking the order on the way */
+    struct skippos last[SKIP_LEVELS];
+    for (int l = 0; l < SKIP_LEVELS; l++)
+        last[l] = (struct skippos){sl->head, NULL, 0};
+    sl->head[0].next = NULL;
+
+    size_t rank = 0;
+    element_t *prev = NULL, *e;
+    list_for_each_entry (e, &q->head, list) {
+        rank++;
+        if (prev && q_element_cmp(prev, e) > 0)
+            goto fail;
+        prev = e;
+
+        int h = skip_height(sl);
+        if (!h)
+            continue;
+        struct skipnode *node =
+            malloc(sizeof(*node) + h * sizeof(struct skiplink));
+        if (!node)
+            goto fail;
+        node->e = e;
+        node->link[0].next = NULL;
+        for (int l = 0; l < h; l++) {
+            last[l].link[l].next = node;
+            last[l].link[l].span = rank - last[l].rank;
+            last[l] = (struct skippos){node->link, e, rank};
+        }
+    }
+    for (int l = 0; l < SKIP_LEVELS; l++) {
+        last[l].link[l].next = NULL;
+        last[l].link[l].span = rank + 1 - last[l].rank;
+    }
+    q->skip_valid = true;
+    return true;
+
+fail:
+    skip_free(q);
+    return false;
+}
+
+/* Walk down from the header to the last tower before @s on each level,
+ * stepping over towers equal to @s as well if @after_equal, and record the
+ * towers reached in @path if not NULL
+ */
+static struct skippos skip_descend(struct skiplist *sl,
+                                   uint64_t key,
+                                   const char *s,
+                                   bool after_equal,
+                                   struct skippos *path)
+{
+    struct skippos pos = {sl->head, NULL, 0};
+    for (int l = SKIP_LEVELS - 1; l >= 0; l--) {
+        struct skipnode *next;
+        while ((next = pos.link[l].next)) {
+            int cmp = skip_cmp(next->e, key, s);
+            if (cmp > 0 || (!cmp && !after_equal))
+                break;
+            pos = (struct skippos){next->link, next->e,
+                                   pos.rank + pos.link[l].span};
+        }
+        if (path)
+            path[l] = pos;
+    }
+    return pos;
+}
+
+/* The list node of the element or header @pos stands on */
+static inline struct list_head *skip_node(queue_t *q, struct skippos pos)
+{
+    return pos.e ? &pos.e->list : &q->head;
+}
+
+element_t *skip_find(queue_t *q, const char *s)
+{
+    uint64_t key = q_key(s);
+    struct skippos pos = skip_descend(q->skip, key, s, false, NULL);
+
+    /* Finish on the list, past a few elements at most */
+    struct list_head *node = skip_node(q, pos)->next;
+    for (; node != &q->head; node = node->next) {
+        element_t *e = list_entry(node, element_t, list);
+        int cmp = skip_cmp(e, key, s);
+        if (cmp >= 0)
+            return cmp ? NULL : e;
+    }
+    return NULL;
+}
+
+void skip_insert(queue_t *q, element_t *e)
+{
+    struct skiplist *sl = q->skip;
+    struct skippos path[SKIP_LEVELS];
+    struct skippos pos = skip_descend(sl, e->key, e->value, true, path);
+
+    struct list_head *node = skip_node(q, pos);
+    size_t rank = pos.rank + 1;
+    for (; node->next != &q->head; node = node->next, rank++) {
+        if (q_element_cmp(list_entry(node->next, element_t, list), e) > 0)
+            break;
+    }
+    list_add(&e->list, node);
+
+    /* Going without a tower only makes searches a little longer */
+    int h = skip_height(sl);
+    struct skipnode *tower =
+        h ? malloc(sizeof(*tower) + h * sizeof(struct skiplink)) : NULL;
+    if (!tower)
+        h = 0;
+    else
+        tower->e = e;
+
+    for (int l = 0; l < SKIP_LEVELS; l++) {
+        struct skiplink *link = &path[l].link[l];
+        if (l < h) {
+            tower->link[l].next = link->next;
+            tower->link[l].span = path[l].rank + link->span + 1 - rank;
+            link->next = tower;
+            link->span = rank - path[l].rank;
+        } else {
+            link->span++;
+        }
+    }
+}
+
+element_t *skip_delete_at(queue_t *q, size_t i)
+{
+    struct skippos pos = {q->skip->head, NULL, 0};
+    struct skipnode *found = NULL;
+    size_t rank = i + 1;
+
+    for (int l = SKIP_LEVELS - 1; l >= 0; l--) {
+        struct skipnode *next;
+        while ((next = pos.link[l].next) && pos.rank + pos.link[l].span < rank)
+            pos = (struct skippos){next->link, next->e,
+                                   pos.rank + pos.link[l].span};
+
+        /* Unlink the tower of the element, or shorten the link over it */
+        struct skiplink *link = &pos.link[l];
+        if (next && pos.rank + link->span == rank) {
+            found = next;
+            link->span += next->link[l].span - 1;
+            link->next = next->link[l].next;
+        } else {
+            link->span--;
+        }
+    }
+
+    if (found) {
+        element_t *e = found->e;
+        free(found);
+        return e;
+    }
+    struct list_head *node = skip_node(q, pos);
+    for (; pos.rank < rank; pos.rank++)
+        node = node->next;
+    return list_entry(node, element_t, list);
+}
@@ -0,0 +1,71 @@
+#ifndef LAB0_SKIPLIST_H
+#define LAB0_SKIPLIST_H
+
+/* Skip-list index over a queue sorted in ascending order, behind
+ * q_insert_sorted() and q_find().
+ *
+ * The list of the queue is the bottom level of the skip list: about one
+ * element in four also gets a tower of links to elements further down the
+ * queue, each link recording how many elements it spans. Searching by string
+ * or by position takes expected O(log n) steps. q_remove_head(),
+ * q_remove_tail() and q_delete_mid() keep the index in sync; every other
+ * operation linking or reordering elements marks it stale, and the next
+ * skip_sync() rebuilds it from the list.
+ *
+ * Every function here expects @q->size to still count the elements before
+ * the change it mirrors.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+static inline void skip_invalidate(queue_t *q)
+{
+    q->skip_valid = false;
+}
+
+/* Release the index of @q, if any */
+void skip_free(queue_t *q);
+
+/**
+ * skip_sync() - Make sure the index mirrors the list, rebuilding it if stale
+ * @q: the queue
+ *
+ * Return: true if the index can be used, false if the queue is not in
+ * ascending order or memory ran out
+ */
+bool skip_sync(queue_t *q);
+
+/**
+ * skip_find() - Look up a string in a queue whose index is in sync
+ * @q: the queue
+ * @s: the string
+ *
+ * Return: the first element holding @s, %NULL if there is none
+ */
+element_t *skip_find(queue_t *q, const char *s);
+
+/**
+ * skip_insert() - Link an element into a queue whose index is in sync
+ * @q: the queue
+ * @e: the element, not on any list yet
+ *
+ * @e goes after the elements comparing less than or equal to it, which keeps
+ * the queue sorted and the insertion stable.
+ */
+void skip_insert(queue_t *q, element_t *e);
+
+/**
+ * skip_delete_at() - Drop the @i-th element from an index in sync
+ * @q: the queue
+ * @i: index from the head
+ *
+ * The element stays on the list: unlinking it is up to the caller.
+ *
+ * Return: the element dropped
+ */
+element_t *skip_delete_at(queue_t *q, size_t i);
+
+#endif /* LAB0_SKIPLIST_H */
@@ -0,0 +1,94 @@
+/* Single-producer/single-consumer ring, see spsc.h */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/* The harness is not thread-safe: use the allocator of the C library */
+#define INTERNAL 1
+#include "harness.h"
+#include "spsc.h"
+
+#define CACHE_LINE 64
+
+struct spsc {
+    /* Written by the producer */
+    _Alignas(CACHE_LINE) atomic_size_t tail;
+    size_t head_cache;
+
+    /* Written by the consumer */
+    _Alignas(CACHE_LINE) atomic_size_t head;
+    size_t tail_cache;
+
+    /* Read-only once created */
+    _Alignas(CACHE_LINE) size_t mask;
+    element_t **slot;
+};
+
+spsc_t *spsc_new(size_t cap)
+{
+    size_t n = 1;
+    while (n < cap)
+        n <<= 1;
+
+    spsc_t *q = aligned_alloc(CACHE_LINE, sizeof(*q));
+    element_t **slot = malloc(n * sizeof(*slot));
+    if (!q || !slot) {
+        free(q);
+        free(slot);
+        return NULL;
+    }
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    q->head_cache = q->tail_cache = 0;
+    q->mask = n - 1;
+    q->slot = slot;
+    return q;
+}
+
+void spsc_free(spsc_t *q)
+{
+    if (!q)
+        return;
+    free(q->slot);
+    free(q);
+}
+
+size_t spsc_enqueue_bulk(spsc_t *q, element_t **ev, size_t n)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t room = q->mask + 1 - (tail - q->head_cache);
+    if (room < n) {
+        /* Pairs with the release store of the consumer: the slots it
+         * freed are no longer read
+         */
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        room = q->mask + 1 - (tail - q->head_cache);
+        if (n > room)
+            n = room;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        q->slot[(tail + i) & q->mask] = ev[i];
+    atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+    return n;
+}
+
+size_t spsc_dequeue_bulk(spsc_t *q, element_t **ev, size_t n)
+{
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    size_t avail = q->tail_cache - head;
+    if (avail < n) {
+        /* Pairs with the release store of the producer: the slots it
+         * filled are visible
+         */
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        avail = q->tail_cache - head;
+        if (n > avail)
+            n = avail;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        ev[i] = q->slot[(head + i) & q->mask];
+    atomic_store_explicit(&q->head, head + n, memory_order_release);
+    return n;
+}
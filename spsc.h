@@ -0,0 +1,70 @@
+#ifndef LAB0_SPSC_H
+#define LAB0_SPSC_H
+
+/* Bounded single-producer/single-consumer ring of elements.
+ *
+ * One thread enqueues and one thread dequeues, each without waiting on the
+ * other: the producer owns the tail index and the consumer the head index,
+ * each published with a release store and read with an acquire load by the
+ * other side. Both also keep a cached copy of the index of the other side,
+ * refreshed only when the ring looks full or empty, so that most operations
+ * touch no cache line written by the other thread. The indices run freely
+ * and are reduced modulo the capacity, a power of two, on access.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+typedef struct spsc spsc_t;
+
+/**
+ * spsc_new() - Create an empty ring
+ * @cap: the number of slots, rounded up to a power of two
+ *
+ * Return: %NULL for allocation failed
+ */
+spsc_t *spsc_new(size_t cap);
+
+/* Free the ring, no effect if @q is NULL. Elements still queued are left to
+ * their owner.
+ */
+void spsc_free(spsc_t *q);
+
+/**
+ * spsc_enqueue_bulk() - Append elements at the tail, producer side
+ * @q: the ring
+ * @ev: the elements
+ * @n: the number of elements in @ev
+ *
+ * Return: the number of elements appended, from @ev[0] on, fewer than @n if
+ * the ring filled up
+ */
+size_t spsc_enqueue_bulk(spsc_t *q, element_t **ev, size_t n);
+
+/**
+ * spsc_dequeue_bulk() - Take elements from the head, consumer side
+ * @q: the ring
+ * @ev: receives the elements
+ * @n: room in @ev
+ *
+ * Return: the number of elements taken, 0 if the ring is empty
+ */
+size_t spsc_dequeue_bulk(spsc_t *q, element_t **ev, size_t n);
+
+/* Single-element forms of the above: false if the ring is full, %NULL if it
+ * is empty
+ */
+static inline bool spsc_enqueue(spsc_t *q, element_t *e)
+{
+    return spsc_enqueue_bulk(q, &e, 1);
+}
+
+static inline element_t *spsc_dequeue(spsc_t *q)
+{
+    element_t *e;
+    return spsc_dequeue_bulk(q, &e, 1) ? e : NULL;
+}
+
+#endif /* LAB0_SPSC_H */
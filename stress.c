@@ -0,0 +1,536 @@
+/* Stress tests of the concurrent queues, see stress.h */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Our program needs to use regular malloc/free */
+#define INTERNAL 1
+#include "harness.h"
+
+#include "mpmc.h"
+#include "report.h"
+#include "spsc.h"
+#include "stress.h"
+#include "twolock.h"
+#include "wsdeque.h"
+
+/* Elements handed between threads by the stress tests. The key of each one
+ * holds its index, the string is not used.
+ */
+static element_t *stress_pool(int n)
+{
+    element_t *pool = malloc((size_t) n * sizeof(element_t));
+    if (!pool) {
+        report(1, "INTERNAL ERROR.  Could not allocate %d elements", n);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        pool[i].value = NULL;
+        pool[i].key = i;
+        pool[i].len = 0;
+        pool[i].chunk = NULL;
+    }
+    return pool;
+}
+
+/* Check that every element of @pool was received exactly once */
+static bool stress_check(const atomic_uchar *seen, int n)
+{
+    for (int i = 0; i < n; i++) {
+        if (seen[i] != 1) {
+            report(1, "ERROR: Element %d received %d times", i, seen[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+struct mpmc_worker {
+    pthread_t tid;
+    mpmc_t *q;
+    element_t *pool;
+    atomic_uchar *seen;
+    atomic_int *consumed;
+    int id, stride, n;
+    bool attached;
+};
+
+/* Enqueue elements id, id + stride, ... of the pool */
+static void *mpmc_producer(void *arg)
+{
+    struct mpmc_worker *w = arg;
+    int slot = mpmc_attach(w->q);
+    if (slot < 0) {
+        /* Let the consumers return, as the elements will never come */
+        atomic_store(w->consumed, w->n);
+        return NULL;
+    }
+    w->attached = true;
+    for (int i = w->id; i < w->n; i += w->stride) {
+        while (!mpmc_enqueue(w->q, slot, &w->pool[i]))
+            sched_yield();
+    }
+    mpmc_detach(w->q, slot);
+    return NULL;
+}
+
+/* Dequeue until all elements of the pool were seen by some consumer */
+static void *mpmc_consumer(void *arg)
+{
+    struct mpmc_worker *w = arg;
+    int slot = mpmc_attach(w->q);
+    if (slot < 0)
+        return NULL;
+    w->attached = true;
+    while (atomic_load(w->consumed) < w->n) {
+        element_t *e = mpmc_dequeue(w->q, slot);
+        if (!e) {
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_add(&w->seen[e->key], 1);
+        atomic_fetch_add(w->consumed, 1);
+    }
+    mpmc_detach(w->q, slot);
+    return NULL;
+}
+
+bool stress_mpmc(int producers, int consumers, int n)
+{
+    int nthreads = producers + consumers;
+    element_t *pool = stress_pool(n);
+    atomic_uchar *seen = calloc(n, sizeof(*seen));
+    struct mpmc_worker *w = calloc(nthreads, sizeof(*w));
+    mpmc_t *q = mpmc_new();
+    atomic_int consumed = 0;
+    bool ok = pool && seen && w && q;
+    if (!ok)
+        report(1, "INTERNAL ERROR.  Could not set up the stress test");
+
+    double t = 0;
+    int started = 0;
+    init_time(&t);
+    for (int i = 0; ok && i < nthreads; i++, started++) {
+        bool producer = i < producers;
+        w[i] = (struct mpmc_worker){
+            .q = q,
+            .pool = pool,
+            .seen = seen,
+            .consumed = &consumed,
+            .id = producer ? i : i - producers,
+            .stride = producers,
+            .n = n,
+        };
+        if (pthread_create(&w[i].tid, NULL,
+                           producer ? mpmc_producer : mpmc_consumer, &w[i])) {
+            report(1, "ERROR: Could not start thread %d", i);
+            /* Let the consumers started so far return */
+            atomic_store(&consumed, n);
+            ok = false;
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(w[i].tid, NULL);
+        if (ok && !w[i].attached) {
+            report(1, "ERROR: No hazard slot left for thread %d", i);
+            ok = false;
+        }
+    }
+    double elapsed = delta_time(&t);
+
+    int slot = ok ? mpmc_attach(q) : -1;
+    if (ok && slot < 0) {
+        report(1, "ERROR: No hazard slot left to check the queue");
+        ok = false;
+    }
+    if (ok && mpmc_dequeue(q, slot)) {
+        report(1, "ERROR: Queue not empty after all elements were consumed");
+        ok = false;
+    }
+    ok = ok && stress_check(seen, n);
+    if (ok)
+        report(1, "%d producers, %d consumers: %d elements, %.0f ops/sec",
+               producers, consumers, n, 2.0 * n / elapsed);
+
+    mpmc_free(q);
+    free(w);
+    free(seen);
+    free(pool);
+    return ok;
+}
+
+/* Slots of the ring used by stress_spsc() */
+#define SPSC_RING_SIZE 1024
+
+struct spsc_side {
+    pthread_t tid;
+    spsc_t *q;
+    element_t *pool;
+    uint64_t *latency;
+    int n, batch;
+    bool ok;
+};
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Send the elements of the pool in order, stamping each with the time */
+static void *spsc_producer(void *arg)
+{
+    struct spsc_side *p = arg;
+    element_t *ev[SPSC_MAX_BATCH];
+    for (int i = 0; i < p->n;) {
+        int m = p->n - i < p->batch ? p->n - i : p->batch;
+        uint64_t t = now_ns();
+        for (int j = 0; j < m; j++) {
+            ev[j] = &p->pool[i + j];
+            ev[j]->key = t;
+        }
+        size_t sent = 0;
+        while (sent < (size_t) m) {
+            size_t k = spsc_enqueue_bulk(p->q, ev + sent, m - sent);
+            if (!k)
+                sched_yield();
+            sent += k;
+        }
+        i += m;
+    }
+    return NULL;
+}
+
+/* Receive the elements, checking they come in pool order */
+static void *spsc_consumer(void *arg)
+{
+    struct spsc_side *c = arg;
+    element_t *ev[SPSC_MAX_BATCH];
+    c->ok = true;
+    for (int i = 0; i < c->n;) {
+        size_t k = spsc_dequeue_bulk(c->q, ev, c->batch);
+        if (!k) {
+            sched_yield();
+            continue;
+        }
+        uint64_t t = now_ns();
+        for (size_t j = 0; j < k; j++, i++) {
+            c->ok = c->ok && ev[j] == &c->pool[i];
+            c->latency[i] = t - ev[j]->key;
+        }
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+bool stress_spsc(int n, int batch)
+{
+    element_t *pool = stress_pool(n);
+    uint64_t *latency = malloc((size_t) n * sizeof(*latency));
+    spsc_t *q = spsc_new(SPSC_RING_SIZE);
+    bool ok = pool && latency && q;
+    if (!ok)
+        report(1, "INTERNAL ERROR.  Could not set up the benchmark");
+
+    struct spsc_side p = {.q = q, .pool = pool, .n = n, .batch = batch};
+    struct spsc_side c = p;
+    c.latency = latency;
+    double t = 0;
+    init_time(&t);
+    if (ok && pthread_create(&c.tid, NULL, spsc_consumer, &c)) {
+        report(1, "ERROR: Could not start the consumer thread");
+        ok = false;
+    }
+    if (ok) {
+        spsc_producer(&p);
+        pthread_join(c.tid, NULL);
+    }
+    double elapsed = delta_time(&t);
+
+    if (ok && !c.ok) {
+        report(1, "ERROR: Messages received out of order");
+        ok = false;
+    }
+    if (ok) {
+        qsort(latency, n, sizeof(*latency), cmp_u64);
+        report(1, "%d messages, batch %d: %.0f msgs/sec", n, batch,
+               n / elapsed);
+        report(1,
+               "Latency (ns): p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, "
+               "max %llu",
+               (unsigned long long) latency[n / 2],
+               (unsigned long long) latency[(size_t) n * 9 / 10],
+               (unsigned long long) latency[(size_t) n * 99 / 100],
+               (unsigned long long) latency[(size_t) n * 999 / 1000],
+               (unsigned long long) latency[n - 1]);
+    }
+
+    spsc_free(q);
+    free(latency);
+    free(pool);
+    return ok;
+}
+
+/* Longest wait of a twolock consumer before checking whether it is done */
+#define TWOLOCK_WAIT_MS 10
+
+struct twolock_worker {
+    pthread_t tid;
+    twolock_t *q;
+    atomic_uchar *seen;
+    atomic_int *consumed;
+    int id, stride, n;
+    long timeouts;
+};
+
+/* Insert the decimal strings of id, id + stride, ... */
+static void *twolock_producer(void *arg)
+{
+    struct twolock_worker *w = arg;
+    char buf[16];
+    for (int i = w->id; i < w->n; i += w->stride) {
+        snprintf(buf, sizeof(buf), "%d", i);
+        while (!twolock_insert_tail(w->q, buf))
+            sched_yield();
+    }
+    return NULL;
+}
+
+/* Block for strings until all of them were seen by some consumer */
+static void *twolock_consumer(void *arg)
+{
+    struct twolock_worker *w = arg;
+    char buf[16];
+    while (atomic_load(w->consumed) < w->n) {
+        if (!twolock_remove_head_timed(w->q, buf, sizeof(buf),
+                                       TWOLOCK_WAIT_MS)) {
+            w->timeouts++;
+            continue;
+        }
+        int i = atoi(buf);
+        if (i >= 0 && i < w->n)
+            atomic_fetch_add(&w->seen[i], 1);
+        atomic_fetch_add(w->consumed, 1);
+    }
+    return NULL;
+}
+
+bool stress_twolock(int producers, int consumers, int n)
+{
+    int nthreads = producers + consumers;
+    atomic_uchar *seen = calloc(n, sizeof(*seen));
+    struct twolock_worker *w = calloc(nthreads, sizeof(*w));
+    twolock_t *q = twolock_new();
+    atomic_int consumed = 0;
+    bool ok = seen && w && q;
+    if (!ok)
+        report(1, "INTERNAL ERROR.  Could not set up the stress test");
+
+    /* Start the consumers first, so that they block on the empty queue */
+    double t = 0;
+    int started = 0;
+    init_time(&t);
+    for (int i = 0; ok && i < nthreads; i++, started++) {
+        bool producer = i >= consumers;
+        w[i] = (struct twolock_worker){
+            .q = q,
+            .seen = seen,
+            .consumed = &consumed,
+            .id = producer ? i - consumers : i,
+            .stride = producers,
+            .n = n,
+        };
+        if (pthread_create(&w[i].tid, NULL,
+                           producer ? twolock_producer : twolock_consumer,
+                           &w[i])) {
+            report(1, "ERROR: Could not start thread %d", i);
+            atomic_store(&consumed, n);
+            ok = false;
+            break;
+        }
+    }
+    long timeouts = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(w[i].tid, NULL);
+        timeouts += w[i].timeouts;
+    }
+    double elapsed = delta_time(&t);
+
+    if (ok && twolock_remove_head(q, NULL, 0)) {
+        report(1, "ERROR: Queue not empty after all elements were consumed");
+        ok = false;
+    }
+    ok = ok && stress_check(seen, n);
+    if (ok)
+        report(1,
+               "%d producers, %d consumers: %d elements, %.0f ops/sec, "
+               "%ld timed out waits",
+               producers, consumers, n, 2.0 * n / elapsed, timeouts);
+
+    twolock_free(q);
+    free(w);
+    free(seen);
+    return ok;
+}
+
+/* Rounds of busy work standing for the computation of each task */
+#define FORKJOIN_WORK 200
+
+struct forkjoin_worker {
+    pthread_t tid;
+    wsdeque_t *q;
+    struct forkjoin_worker *all;
+    element_t *pool;
+    atomic_uchar *seen;
+    atomic_int *done;
+    int id, nworkers, n;
+    uint32_t seed, sink;
+    long tasks, steals;
+    bool failed;
+};
+
+/* Steal from the other workers, starting at a random one */
+static element_t *forkjoin_steal(struct forkjoin_worker *w)
+{
+    /* xorshift32 */
+    w->seed ^= w->seed << 13;
+    w->seed ^= w->seed >> 17;
+    w->seed ^= w->seed << 5;
+
+    int start = w->seed % w->nworkers;
+    for (int i = 0; i < w->nworkers; i++) {
+        int victim = (start + i) % w->nworkers;
+        if (victim == w->id)
+            continue;
+        element_t *e = wsdeque_steal(w->all[victim].q);
+        if (e)
+            return e;
+    }
+    return NULL;
+}
+
+/* Run tasks until all of them are done. Task i of the pool forks tasks
+ * 2i + 1 and 2i + 2, so that the n tasks make up a binary tree whose root,
+ * task 0, is on the deque of worker 0 to begin with.
+ */
+static void *forkjoin_worker(void *arg)
+{
+    struct forkjoin_worker *w = arg;
+    while (atomic_load(w->done) < w->n) {
+        element_t *e = wsdeque_pop(w->q);
+        if (!e && (e = forkjoin_steal(w)))
+            w->steals++;
+        if (!e) {
+            sched_yield();
+            continue;
+        }
+
+        int i = e->key;
+        for (int child = 2 * i + 1; child <= 2 * i + 2 && child < w->n;
+             child++) {
+            if (!wsdeque_push(w->q, &w->pool[child])) {
+                /* Stop everyone */
+                w->failed = true;
+                atomic_store(w->done, w->n);
+                return NULL;
+            }
+        }
+        uint32_t x = w->seed | 1;
+        for (int k = 0; k < FORKJOIN_WORK; k++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+        }
+        w->sink += x;
+        w->tasks++;
+        atomic_fetch_add(&w->seen[i], 1);
+        atomic_fetch_add(w->done, 1);
+    }
+    return NULL;
+}
+
+bool stress_forkjoin(int nworkers, int n)
+{
+    element_t *pool = stress_pool(n);
+    atomic_uchar *seen = calloc(n, sizeof(*seen));
+    struct forkjoin_worker *w = calloc(nworkers, sizeof(*w));
+    bool ok = pool && seen && w;
+    for (int i = 0; ok && i < nworkers; i++) {
+        w[i] = (struct forkjoin_worker){
+            .q = wsdeque_new(),
+            .all = w,
+            .pool = pool,
+            .seen = seen,
+            .id = i,
+            .nworkers = nworkers,
+            .n = n,
+            .seed = 2463534242u + i,
+        };
+        ok = w[i].q;
+    }
+    ok = ok && wsdeque_push(w[0].q, &pool[0]);
+    if (!ok)
+        report(1, "INTERNAL ERROR.  Could not set up the stress test");
+
+    atomic_int done = 0;
+    double t = 0;
+    int started = 0;
+    init_time(&t);
+    for (int i = 0; ok && i < nworkers; i++, started++) {
+        w[i].done = &done;
+        if (pthread_create(&w[i].tid, NULL, forkjoin_worker, &w[i])) {
+            report(1, "ERROR: Could not start thread %d", i);
+            atomic_store(&done, n);
+            ok = false;
+            break;
+        }
+    }
+    long steals = 0, most = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(w[i].tid, NULL);
+        if (w[i].failed) {
+            report(1, "ERROR: Worker %d could not grow its deque", i);
+            ok = false;
+        }
+        steals += w[i].steals;
+        if (w[i].tasks > most)
+            most = w[i].tasks;
+    }
+    double elapsed = delta_time(&t);
+
+    for (int i = 0; ok && i < nworkers; i++) {
+        if (wsdeque_pop(w[i].q)) {
+            report(1, "ERROR: Deque of worker %d not empty at the end", i);
+            ok = false;
+        }
+    }
+    ok = ok && stress_check(seen, n);
+    if (ok) {
+        report(1, "%d workers, %d tasks: %.0f tasks/sec, %ld steals",
+               nworkers, n, n / elapsed, steals);
+        for (int i = 0; i < nworkers; i++)
+            report(1, "  worker %d: %ld tasks (%.1f%%), %ld steals", i,
+                   w[i].tasks, 100.0 * w[i].tasks / n, w[i].steals);
+        /* 1 for work spread evenly, nworkers for a single busy worker */
+        report(1, "Load imbalance (busiest / mean): %.2f",
+               (double) most * nworkers / n);
+    }
+
+    for (int i = 0; w && i < nworkers; i++)
+        wsdeque_free(w[i].q);
+    free(w);
+    free(seen);
+    free(pool);
+    return ok;
+}
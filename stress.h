@@ -0,0 +1,71 @@
+#ifndef LAB0_STRESS_H
+#define LAB0_STRESS_H
+
+/* Stress tests of the concurrent queues, run by the qtest commands of the
+ * same names. Each one runs threads against a queue, checks that every
+ * element went through exactly once, and reports the throughput or the first
+ * error found through report().
+ *
+ * Elements and queues come from the C library, not from the harness, which
+ * is not thread-safe.
+ */
+
+#include <stdbool.h>
+
+/**
+ * stress_mpmc() - Pass elements through a queue of mpmc.h
+ * @producers: the number of threads enqueuing, at least 1
+ * @consumers: the number of threads dequeuing, at least 1
+ * @n: the number of elements, at least 1
+ *
+ * @producers and @consumers add up to MPMC_MAX_THREADS at most.
+ *
+ * Return: true if every element was dequeued exactly once
+ */
+bool stress_mpmc(int producers, int consumers, int n);
+
+/* Most elements moved at once by stress_spsc() */
+#define SPSC_MAX_BATCH 256
+
+/**
+ * stress_spsc() - Send elements through a ring of spsc.h to a second thread
+ * @n: the number of elements, at least 1
+ * @batch: the most elements sent or received at once, 1 to SPSC_MAX_BATCH
+ *
+ * Besides the throughput, reports percentiles of the latency of the elements,
+ * from the time they are sent to the time they are received.
+ *
+ * Return: true if the elements were received in the order they were sent
+ */
+bool stress_spsc(int n, int batch);
+
+/**
+ * stress_twolock() - Pass strings through a queue of twolock.h
+ * @producers: the number of threads inserting, at least 1
+ * @consumers: the number of threads removing, at least 1
+ * @n: the number of strings, at least 1
+ *
+ * The consumers block on the queue with a timeout, and the timed out waits
+ * are reported along with the throughput.
+ *
+ * Return: true if every string was removed exactly once
+ */
+bool stress_twolock(int producers, int consumers, int n);
+
+/* Most workers of stress_forkjoin() */
+#define FORKJOIN_MAX_WORKERS 64
+
+/**
+ * stress_forkjoin() - Run a tree of tasks on workers with deques of wsdeque.h
+ * @nworkers: the number of worker threads, 1 to FORKJOIN_MAX_WORKERS
+ * @n: the number of tasks, at least 1
+ *
+ * Each worker runs tasks from its own deque and steals from the others when
+ * it runs dry. Reports the throughput, the tasks run and stolen by each
+ * worker and the resulting load imbalance.
+ *
+ * Return: true if every task ran exactly once
+ */
+bool stress_forkjoin(int nworkers, int n);
+
+#endif /* LAB0_STRESS_H */
@@ -0,0 +1,289 @@
+/* Natural-run merge sort for circular doubly-linked lists
+ *
+ * This follows the design of Tim Peters' listsort, described in CPython's
+ * Objects/listsort.txt, adapted to linked lists: runs are null-terminated
+ * singly-linked chains, so merging never moves data and needs no temporary
+ * storage, and galloping walks the chain instead of indexing an array.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "timsort.h"
+
+/* Consecutive wins from the same run before a merge starts galloping */
+#define MIN_GALLOP 7
+
+/* The merge policy keeps run lengths growing at least as fast as Fibonacci
+ * numbers, so this many pending runs is enough for 2^64 elements.
+ */
+#define MAX_PENDING 85
+
+struct run {
+    struct list_head *head, *tail;
+    size_t len;
+};
+
+struct sort_state {
+    void *priv;
+    list_cmp_func_t cmp;
+    size_t min_gallop;
+};
+
+/* Whether @node belongs before @key in the merged output. Nodes of the left
+ * run win ties (@strict false), nodes of the right run do not (@strict true),
+ * which keeps the merge stable.
+ */
+static inline bool precedes(struct sort_state *s,
+                            const struct list_head *node,
+                            const struct list_head *key,
+                            bool strict)
+{
+    int ret = s->cmp(s->priv, node, key);
+    return strict ? ret < 0 : ret <= 0;
+}
+
+/* Detach the run starting at @list into @run and return what follows it */
+static struct list_head *find_run(struct sort_state *s,
+                                  struct list_head *list,
+                                  struct run *run)
+{
+    struct list_head *head = list, *next = list->next;
+    size_t len = 1;
+
+    if (!next) {
+        run->head = run->tail = head;
+        run->len = len;
+        return NULL;
+    }
+
+    if (s->cmp(s->priv, next, head) < 0) {
+        /* Strictly descending: reverse the run while scanning it */
+        run->tail = head;
+        do {
+            struct list_head *after = next->next;
+            next->next = head;
+            head = next;
+            next = after;
+            len++;
+        } while (next && s->cmp(s->priv, next, head) < 0);
+        run->tail->next = NULL;
+        run->head = head;
+    } else {
+        struct list_head *tail = next;
+        len++;
+        while (tail->next && s->cmp(s->priv, tail->next, tail) >= 0) {
+            tail = tail->next;
+            len++;
+        }
+        next = tail->next;
+        tail->next = NULL;
+        run->head = head;
+        run->tail = tail;
+    }
+    run->len = len;
+    return next;
+}
+
+/* Starting from @node, which is known to precede @key, return the last node
+ * of its chain that still does. The distance is found by probing 1, 2, 4, ...
+ * nodes ahead and then bisecting the last interval, so that skipping k nodes
+ * costs O(log k) comparisons. The number of nodes skipped is stored in @count.
+ */
+static struct list_head *gallop(struct sort_state *s,
+                                struct list_head *node,
+                                const struct list_head *key,
+                                bool strict,
+                                size_t *count)
+{
+    size_t n = 1, step = 1;
+
+    for (;;) {
+        struct list_head *probe = node;
+        size_t i;
+
+        for (i = 0; i < step && probe->next; i++)
+            probe = probe->next;
+        if (!i)
+            break;
+
+        if (precedes(s, probe, key, strict)) {
+            node = probe;
+            n += i;
+            if (i < step) /* Reached the end of the chain */
+                break;
+            step <<= 1;
+            continue;
+        }
+
+        /* The boundary lies within the i - 1 nodes between node and probe */
+        for (size_t left = i - 1; left;) {
+            size_t mid = (left + 1) / 2;
+            struct list_head *m = node;
+
+            for (size_t j = 0; j < mid; j++)
+                m = m->next;
+            if (precedes(s, m, key, strict)) {
+                node = m;
+                n += mid;
+                left -= mid;
+            } else {
+                left = mid - 1;
+            }
+        }
+        break;
+    }
+
+    *count = n;
+    return node;
+}
+
+/* Adjust the galloping threshold after a gallop that skipped @count nodes and
+ * return whether the merge should keep galloping
+ */
+static inline bool gallop_paid_off(struct sort_state *s, size_t count)
+{
+    if (count >= MIN_GALLOP) {
+        if (s->min_gallop > 1)
+            s->min_gallop--;
+        return true;
+    }
+    s->min_gallop++;
+    return false;
+}
+
+/* Merge run @b, which immediately follows run @a in the input, into @a */
+static void merge_runs(struct sort_state *s,
+                       struct run *a,
+                       const struct run *b)
+{
+    a->len += b->len;
+
+    /* Runs already in order, or b entirely before a: just concatenate */
+    if (s->cmp(s->priv, a->tail, b->head) <= 0) {
+        a->tail->next = b->head;
+        a->tail = b->tail;
+        return;
+    }
+    if (s->cmp(s->priv, b->tail, a->head) < 0) {
+        b->tail->next = a->head;
+        a->head = b->head;
+        return;
+    }
+
+    struct list_head *x = a->head, *y = b->head;
+    struct list_head *head = NULL, **tail = &head;
+    size_t wins_x = 0, wins_y = 0;
+    bool galloping = false;
+
+    while (x && y) {
+        struct list_head *end;
+        size_t count;
+
+        if (precedes(s, x, y, false)) {
+            end = x;
+            wins_y = 0;
+            if (galloping || ++wins_x >= s->min_gallop) {
+                end = gallop(s, x, y, false, &count);
+                galloping = gallop_paid_off(s, count);
+                wins_x = 0;
+            }
+            *tail = x;
+            x = end->next;
+        } else {
+            end = y;
+            wins_x = 0;
+            if (galloping || ++wins_y >= s->min_gallop) {
+                end = gallop(s, y, x, true, &count);
+                galloping = gallop_paid_off(s, count);
+                wins_y = 0;
+            }
+            *tail = y;
+            y = end->next;
+        }
+        tail = &end->next;
+    }
+
+    if (x) {
+        *tail = x;
+    } else {
+        *tail = y;
+        a->tail = b->tail;
+    }
+    a->head = head;
+}
+
+/* Merge runs[i] with runs[i + 1] */
+static void merge_at(struct sort_state *s,
+                     struct run *runs,
+                     size_t *n,
+                     size_t i)
+{
+    merge_runs(s, &runs[i], &runs[i + 1]);
+    if (i + 3 == *n)
+        runs[i + 1] = runs[i + 2];
+    (*n)--;
+}
+
+/* Restore the invariants len[i - 2] > len[i - 1] + len[i] and
+ * len[i - 1] > len[i] on the top of the run stack
+ */
+static void merge_collapse(struct sort_state *s, struct run *runs, size_t *n)
+{
+    while (*n > 1) {
+        size_t i = *n - 2;
+
+        if ((i > 0 && runs[i - 1].len <= runs[i].len + runs[i + 1].len) ||
+            (i > 1 && runs[i - 2].len <= runs[i - 1].len + runs[i].len)) {
+            if (runs[i - 1].len < runs[i + 1].len)
+                i--;
+        } else if (runs[i].len > runs[i + 1].len) {
+            break;
+        }
+        merge_at(s, runs, n, i);
+    }
+}
+
+/* Merge all pending runs into one */
+static void merge_force_collapse(struct sort_state *s,
+                                 struct run *runs,
+                                 size_t *n)
+{
+    while (*n > 1) {
+        size_t i = *n - 2;
+
+        if (i > 0 && runs[i - 1].len < runs[i + 1].len)
+            i--;
+        merge_at(s, runs, n, i);
+    }
+}
+
+void list_timsort(void *priv, struct list_head *head, list_cmp_func_t cmp)
+{
+    struct list_head *list = head->next, *prev = head;
+
+    if (list == head->prev) /* Zero or one elements */
+        return;
+
+    /* Convert to a null-terminated singly-linked list */
+    head->prev->next = NULL;
+
+    struct sort_state s = {.priv = priv, .cmp = cmp, .min_gallop = MIN_GALLOP};
+    struct run runs[MAX_PENDING];
+    size_t n = 0;
+
+    do {
+        list = find_run(&s, list, &runs[n++]);
+        merge_collapse(&s, runs, &n);
+    } while (list);
+    merge_force_collapse(&s, runs, &n);
+
+    /* Rebuild prev links and the circular structure */
+    for (list = runs[0].head; list; list = list->next) {
+        list->prev = prev;
+        prev->next = list;
+        prev = list;
+    }
+    prev->next = head;
+    head->prev = prev;
+}
@@ -0,0 +1,21 @@
+#ifndef LAB0_TIMSORT_H
+#define LAB0_TIMSORT_H
+
+#include "list.h"
+
+/**
+ * list_timsort() - Sort a list by merging its natural runs
+ * @priv: private data passed through to @cmp
+ * @head: pointer to the head of the list
+ * @cmp: comparison function, see list_cmp_func_t
+ *
+ * Adaptive counterpart of list_sort(): the list is cut into maximal
+ * non-descending and strictly descending runs, the latter being reversed in
+ * place, and the runs are merged following Timsort's policy. Already sorted
+ * and reverse-sorted lists are handled in a single pass.
+ *
+ * The sort is stable and does not allocate memory.
+ */
+void list_timsort(void *priv, struct list_head *head, list_cmp_func_t cmp);
+
+#endif /* LAB0_TIMSORT_H */
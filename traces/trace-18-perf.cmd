@@ -0,0 +1,27 @@
+# Test performance of ascend and descend
+option fail 0
+option malloc 0
+new
+ih gerbil 50000
+it dolphin 50000
+ascend
+ih gerbil 50000
+descend
+free
+new
+ih RAND 100000
+ascend
+free
+new
+ih dolphin 500000
+it gerbil 500000
+descend
+it dolphin 500000
+ascend
+free
+new
+it gerbil 500000
+ih dolphin 500000
+ascend
+descend
+free
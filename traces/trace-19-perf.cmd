@@ -0,0 +1,19 @@
+# Test performance of delete duplicate on unsorted queues
+option fail 0
+option malloc 0
+option bulk 1
+option dedup 1
+new
+ih RAND 500000
+it gerbil 250000
+ih dolphin 250000
+dedup
+ih RAND 100000
+it RAND 100000
+dedup
+free
+new
+ih gerbil
+ih RAND 1000000
+it gerbil
+dedup
@@ -0,0 +1,17 @@
+# Test performance of insert and lookup on sorted queues
+option fail 0
+option malloc 0
+new
+ih RAND 200000
+sort
+isorted RAND 50000
+isorted gerbil 1000
+find gerbil
+dm
+rh
+rt
+isorted dolphin 100000
+find dolphin
+ih RAND 100
+find gerbil
+free
@@ -0,0 +1,20 @@
+# Test performance of repeatedly deleting the middle node
+option fail 0
+option malloc 0
+option bulk 1
+new
+ih RAND 1000000
+dm
+it gerbil
+dm
+ih dolphin
+dm
+rh
+dm
+rt
+dm 100000
+reverse
+dm 1000
+it RAND 1000
+dm 100000
+free
@@ -0,0 +1,18 @@
+# Test of malloc failure and performance on bulk insertion
+option fail 30
+option malloc 0
+option bulk 1
+new
+ih jaguar 20
+option malloc 25
+ih gerbil 20
+it dolphin 20
+ih RAND 20
+option malloc 0
+it gerbil 20
+free
+option fail 0
+new
+it gerbil 1000000
+ih RAND 500000
+free
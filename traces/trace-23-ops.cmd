@@ -0,0 +1,50 @@
+# Test of reordering after counted and bulk insertions
+option fail 0
+option malloc 0
+new
+it a 2
+ih b 2
+option bulk 1
+it c 3
+ih d 2
+option bulk 0
+it e
+ih f
+dm
+reverse
+swap
+reverseK 3
+dm
+rh c
+rt d
+option bulk 1
+ih g 70
+it h 65
+option bulk 0
+it i
+ih j
+dm
+reverse
+reverseK 4
+swap
+dm
+sort
+reverse
+rh j
+rh i
+rt a
+rt b
+dm
+swap
+reverseK 5
+rh h 60
+rh g
+rh h 4
+rh g 4
+rh h
+rh g 60
+rh e
+rh g 4
+rh f
+rh d
+free
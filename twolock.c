@@ -0,0 +1,158 @@
+/* Two-lock blocking queue, see twolock.h */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The harness is not thread-safe: use the allocator of the C library */
+#define INTERNAL 1
+#include "harness.h"
+#include "twolock.h"
+
+#define CACHE_LINE 64
+
+struct twolock {
+    /* Taken by consumers */
+    _Alignas(CACHE_LINE) pthread_mutex_t head_lock;
+    pthread_cond_t nonempty;
+    element_t *head; /* the dummy */
+
+    /* Taken by producers */
+    _Alignas(CACHE_LINE) pthread_mutex_t tail_lock;
+    element_t *tail;
+
+    /* Consumers blocked or about to block on @nonempty */
+    _Alignas(CACHE_LINE) atomic_int waiters;
+};
+
+/* The element after @e, %NULL at the tail. A producer may link one while
+ * the consumer reads it, which only happens on the dummy of an empty queue.
+ */
+static inline element_t *next_of(element_t *e)
+{
+    struct list_head *next = __atomic_load_n(&e->list.next, __ATOMIC_SEQ_CST);
+    return next ? list_entry(next, element_t, list) : NULL;
+}
+
+static element_t *element_new(const char *s)
+{
+    size_t len = strlen(s);
+    element_t *e = malloc(sizeof(element_t) + len + 1);
+    if (!e)
+        return NULL;
+    e->value = memcpy(e->data, s, len + 1);
+    e->key = q_key(e->value);
+    e->len = len;
+    e->chunk = NULL;
+    e->list.next = e->list.prev = NULL;
+    return e;
+}
+
+twolock_t *twolock_new(void)
+{
+    twolock_t *q = aligned_alloc(CACHE_LINE, sizeof(*q));
+    element_t *dummy = element_new("");
+    if (!q || !dummy) {
+        free(q);
+        free(dummy);
+        return NULL;
+    }
+
+    pthread_mutex_init(&q->head_lock, NULL);
+    pthread_cond_init(&q->nonempty, NULL);
+    pthread_mutex_init(&q->tail_lock, NULL);
+    q->head = q->tail = dummy;
+    atomic_init(&q->waiters, 0);
+    return q;
+}
+
+void twolock_free(twolock_t *q)
+{
+    if (!q)
+        return;
+
+    element_t *e = q->head;
+    while (e) {
+        element_t *next = next_of(e);
+        free(e);
+        e = next;
+    }
+    pthread_mutex_destroy(&q->head_lock);
+    pthread_cond_destroy(&q->nonempty);
+    pthread_mutex_destroy(&q->tail_lock);
+    free(q);
+}
+
+bool twolock_insert_tail(twolock_t *q, const char *s)
+{
+    element_t *e = element_new(s);
+    if (!e)
+        return false;
+
+    pthread_mutex_lock(&q->tail_lock);
+    __atomic_store_n(&q->tail->list.next, &e->list, __ATOMIC_SEQ_CST);
+    q->tail = e;
+    pthread_mutex_unlock(&q->tail_lock);
+
+    /* A consumer announces itself before looking at the queue, and the
+     * element is linked before looking at the waiters: either the consumer
+     * sees the element or the element is signalled. Taking the head lock
+     * makes sure the consumer waits already.
+     */
+    if (atomic_load(&q->waiters)) {
+        pthread_mutex_lock(&q->head_lock);
+        pthread_cond_signal(&q->nonempty);
+        pthread_mutex_unlock(&q->head_lock);
+    }
+    return true;
+}
+
+bool twolock_remove_head_timed(twolock_t *q,
+                               char *sp,
+                               size_t bufsize,
+                               int timeout_ms)
+{
+    struct timespec deadline;
+    if (timeout_ms > 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long) (timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&q->head_lock);
+    element_t *first = next_of(q->head);
+    if (!first && timeout_ms) {
+        atomic_fetch_add(&q->waiters, 1);
+        int err = 0;
+        while (!(first = next_of(q->head)) && err != ETIMEDOUT) {
+            if (timeout_ms < 0)
+                pthread_cond_wait(&q->nonempty, &q->head_lock);
+            else
+                err = pthread_cond_timedwait(&q->nonempty, &q->head_lock,
+                                             &deadline);
+        }
+        atomic_fetch_sub(&q->waiters, 1);
+    }
+    if (!first) {
+        pthread_mutex_unlock(&q->head_lock);
+        return false;
+    }
+
+    element_t *dummy = q->head;
+    if (sp) {
+        size_t len = first->len < bufsize - 1 ? first->len : bufsize - 1;
+        memcpy(sp, first->value, len);
+        sp[len] = '\0';
+    }
+    q->head = first;
+    pthread_mutex_unlock(&q->head_lock);
+    free(dummy);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef LAB0_TWOLOCK_H
+#define LAB0_TWOLOCK_H
+
+/* Blocking FIFO queue of strings for several threads, after the two-lock
+ * algorithm of Michael and Scott, "Simple, Fast, and Practical Non-Blocking
+ * and Blocking Concurrent Queue Algorithms" (PODC 1996).
+ *
+ * The elements are element_t, singly linked through the next pointer of
+ * their list member and preceded by a dummy element. Insertion only takes
+ * the tail lock and removal only the head lock, so producers and consumers
+ * never wait on each other: the dummy keeps them on different elements even
+ * when the queue is empty. Removal copies the string of the first element
+ * out, then releases the dummy, the first element becoming the new dummy.
+ *
+ * Memory comes from the C library, not from the harness, which is not
+ * thread-safe.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+typedef struct twolock twolock_t;
+
+/* Create an empty queue, %NULL for allocation failed */
+twolock_t *twolock_new(void);
+
+/* Free the queue and its elements, no effect if @q is NULL. No thread may
+ * use the queue any longer.
+ */
+void twolock_free(twolock_t *q);
+
+/**
+ * twolock_insert_tail() - Insert a copy of a string at the tail
+ * @q: the queue
+ * @s: the string
+ *
+ * Wakes up a consumer blocked in twolock_remove_head_timed(), if any.
+ *
+ * Return: true for success, false for allocation failed
+ */
+bool twolock_insert_tail(twolock_t *q, const char *s);
+
+/**
+ * twolock_remove_head_timed() - Remove the element at the head
+ * @q: the queue
+ * @sp: receives the string, up to @bufsize - 1 bytes plus a terminator
+ * @bufsize: size of @sp
+ * @timeout_ms: how long to wait for an element if the queue is empty; 0
+ *              returns at once, a negative value waits as long as it takes
+ *
+ * Return: true if an element was removed, false if the queue stayed empty
+ */
+bool twolock_remove_head_timed(twolock_t *q,
+                               char *sp,
+                               size_t bufsize,
+                               int timeout_ms);
+
+/* Remove the element at the head, false if the queue is empty */
+static inline bool twolock_remove_head(twolock_t *q, char *sp, size_t bufsize)
+{
+    return twolock_remove_head_timed(q, sp, bufsize, 0);
+}
+
+#endif /* LAB0_TWOLOCK_H */
@@ -0,0 +1,228 @@
+/* Unrolled-list index, see qindex.h: the elements of a queue in queue
+ * order, in a list of arrays of up to QCHUNK_SLOTS elements and their keys
+ */
+
+#include <stdlib.h>
+
+#include "qindex.h"
+
+/* Position of an element: a chunk and one of its occupied slots */
+struct cursor {
+    struct qchunk *c;
+    int i;
+};
+
+static void cursor_next(struct cursor *cur)
+{
+    if (++cur->i == cur->c->first + cur->c->count) {
+        cur->c = list_entry(cur->c->link.next, struct qchunk, link);
+        cur->i = cur->c->first;
+    }
+}
+
+static void cursor_prev(struct cursor *cur)
+{
+    if (cur->i-- == cur->c->first) {
+        cur->c = list_entry(cur->c->link.prev, struct qchunk, link);
+        cur->i = cur->c->first + cur->c->count - 1;
+    }
+}
+
+/* Add an empty chunk at one end, filling towards the other end. A spare
+ * chunk is taken first.
+ */
+static struct qchunk *chunk_new(queue_t *q, bool tail)
+{
+    struct qchunk *c;
+    if (!list_empty(&q->spare)) {
+        c = list_first_entry(&q->spare, struct qchunk, link);
+        list_del(&c->link);
+    } else if ((c = malloc(sizeof(*c)))) {
+        q->nchunks++;
+    } else {
+        return NULL;
+    }
+    c->count = 0;
+    if (tail) {
+        c->first = 0;
+        list_add_tail(&c->link, &q->chunks);
+    } else {
+        c->first = QCHUNK_SLOTS;
+        list_add(&c->link, &q->chunks);
+    }
+    return c;
+}
+
+static void chunk_free(queue_t *q, struct qchunk *c)
+{
+    list_del(&c->link);
+    free(c);
+    q->nchunks--;
+}
+
+static void chunks_free(queue_t *q)
+{
+    struct qchunk *c, *safe;
+    list_for_each_entry_safe (c, safe, &q->chunks, link)
+        chunk_free(q, c);
+    list_for_each_entry_safe (c, safe, &q->spare, link)
+        chunk_free(q, c);
+}
+
+/* Chunks are large enough for their allocation to stand out next to an
+ * insertion: queues start with a spare one, and keep one when they empty, so
+ * that pushes and pops cost the same on an empty queue as on a longer one.
+ */
+static void chunk_keep(queue_t *q, struct qchunk *c)
+{
+    if (list_empty(&q->spare))
+        list_move(&c->link, &q->spare);
+    else
+        chunk_free(q, c);
+}
+
+void qindex_init(queue_t *q)
+{
+    INIT_LIST_HEAD(&q->chunks);
+    INIT_LIST_HEAD(&q->spare);
+    q->nchunks = 0;
+    q->index_valid = true;
+    /* Without it the first push allocates instead */
+    struct qchunk *c = malloc(sizeof(*c));
+    if (c) {
+        list_add(&c->link, &q->spare);
+        q->nchunks++;
+    }
+}
+
+void qindex_free(queue_t *q)
+{
+    chunks_free(q);
+}
+
+bool qindex_sync(queue_t *q)
+{
+    if (q->index_valid)
+        return true;
+    if (q->nchunks * QCHUNK_SLOTS < (size_t) q->size)
+        return false;
+
+    /* Pack the elements into full chunks, all taken from the spare ones */
+    list_splice_tail_init(&q->chunks, &q->spare);
+    struct qchunk *c = NULL;
+    element_t *element;
+    list_for_each_entry (element, &q->head, list) {
+        if (!c || c->count == QCHUNK_SLOTS)
+            c = chunk_new(q, true);
+        c->elem[c->count] = element;
+        c->key[c->count++] = element->key;
+    }
+    q->index_valid = true;
+    return true;
+}
+
+void qindex_reserve(queue_t *q, size_t n)
+{
+    while (!q->index_valid && q->nchunks * QCHUNK_SLOTS < n) {
+        struct qchunk *c = malloc(sizeof(*c));
+        if (!c)
+            return;
+        list_add(&c->link, &q->spare);
+        q->nchunks++;
+    }
+}
+
+void qindex_push(queue_t *q, element_t *e, bool tail)
+{
+    if (!q->index_valid) {
+        qindex_reserve(q, q->size + 1);
+        return;
+    }
+
+    struct qchunk *c = NULL;
+    if (!list_empty(&q->chunks)) {
+        c = tail ? list_last_entry(&q->chunks, struct qchunk, link)
+                 : list_first_entry(&q->chunks, struct qchunk, link);
+        if (tail ? c->first + c->count == QCHUNK_SLOTS : !c->first)
+            c = NULL;
+    }
+    /* Failing to grow only costs a rebuild later on */
+    if (!c && !(c = chunk_new(q, tail))) {
+        qindex_invalidate(q);
+        return;
+    }
+
+    int i = tail ? c->first + c->count : --c->first;
+    c->elem[i] = e;
+    c->key[i] = e->key;
+    c->count++;
+}
+
+void qindex_pop(queue_t *q, size_t n, bool tail)
+{
+    if (!q->index_valid)
+        return;
+
+    while (n) {
+        struct qchunk *c =
+            tail ? list_last_entry(&q->chunks, struct qchunk, link)
+                 : list_first_entry(&q->chunks, struct qchunk, link);
+        int m = n < (size_t) c->count ? (int) n : c->count;
+        if (!tail)
+            c->first += m;
+        c->count -= m;
+        if (!c->count)
+            chunk_keep(q, c);
+        n -= m;
+    }
+}
+
+/* Rewrite the links of the list to follow the chunks */
+static void chunks_relink(queue_t *q)
+{
+    struct list_head *prev = &q->head;
+    struct qchunk *c;
+    list_for_each_entry (c, &q->chunks, link) {
+        for (int i = c->first; i < c->first + c->count; i++) {
+            struct list_head *node = &c->elem[i]->list;
+            prev->next = node;
+            node->prev = prev;
+            prev = node;
+        }
+    }
+    prev->next = &q->head;
+    q->head.prev = prev;
+}
+
+bool qindex_reverseK(queue_t *q, size_t k)
+{
+    size_t n = q->size;
+    if (k < 2 || k > n)
+        return true;
+
+    struct cursor lo = {list_first_entry(&q->chunks, struct qchunk, link)};
+    lo.i = lo.c->first;
+    for (size_t g = 0; g + k <= n; g += k) {
+        /* Find the end of the group, then swap inwards from both ends */
+        struct cursor hi = lo, next;
+        for (size_t j = 1; j < k; j++)
+            cursor_next(&hi);
+        next = hi;
+        if (g + k < n)
+            cursor_next(&next);
+
+        for (size_t j = 0; j < k / 2; j++) {
+            element_t *e = lo.c->elem[lo.i];
+            uint64_t key = lo.c->key[lo.i];
+            lo.c->elem[lo.i] = hi.c->elem[hi.i];
+            lo.c->key[lo.i] = hi.c->key[hi.i];
+            hi.c->elem[hi.i] = e;
+            hi.c->key[hi.i] = key;
+            cursor_next(&lo);
+            cursor_prev(&hi);
+        }
+        lo = next;
+    }
+    chunks_relink(q);
+    return true;
+}
@@ -0,0 +1,147 @@
+/* Chase-Lev work-stealing deque, see wsdeque.h */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The harness is not thread-safe: use the allocator of the C library */
+#define INTERNAL 1
+#include "harness.h"
+#include "wsdeque.h"
+
+#define CACHE_LINE 64
+
+/* Slots of the first array */
+#define WSDEQUE_MIN 64
+
+struct wsarray {
+    struct wsarray *replaced; /* the smaller array this one took over from */
+    size_t mask;
+    _Atomic(element_t *) slot[];
+};
+
+struct wsdeque {
+    /* Advanced by thieves */
+    _Alignas(CACHE_LINE) _Atomic int64_t top;
+
+    /* Owned by the owner */
+    _Alignas(CACHE_LINE) _Atomic int64_t bottom;
+    _Atomic(struct wsarray *) array;
+};
+
+static struct wsarray *wsarray_new(size_t size, struct wsarray *replaced)
+{
+    struct wsarray *a = malloc(sizeof(*a) + size * sizeof(a->slot[0]));
+    if (!a)
+        return NULL;
+    a->replaced = replaced;
+    a->mask = size - 1;
+    return a;
+}
+
+wsdeque_t *wsdeque_new(void)
+{
+    wsdeque_t *q = aligned_alloc(CACHE_LINE, sizeof(*q));
+    struct wsarray *a = wsarray_new(WSDEQUE_MIN, NULL);
+    if (!q || !a) {
+        free(q);
+        free(a);
+        return NULL;
+    }
+    atomic_init(&q->top, 0);
+    atomic_init(&q->bottom, 0);
+    atomic_init(&q->array, a);
+    return q;
+}
+
+void wsdeque_free(wsdeque_t *q)
+{
+    if (!q)
+        return;
+
+    struct wsarray *a = atomic_load(&q->array);
+    while (a) {
+        struct wsarray *replaced = a->replaced;
+        free(a);
+        a = replaced;
+    }
+    free(q);
+}
+
+/* Move elements @t to @b - 1 into an array twice as large */
+static struct wsarray *grow(wsdeque_t *q,
+                            struct wsarray *a,
+                            int64_t t,
+                            int64_t b)
+{
+    struct wsarray *bigger = wsarray_new(2 * (a->mask + 1), a);
+    if (!bigger)
+        return NULL;
+    for (int64_t i = t; i < b; i++) {
+        element_t *e =
+            atomic_load_explicit(&a->slot[i & a->mask], memory_order_relaxed);
+        atomic_store_explicit(&bigger->slot[i & bigger->mask], e,
+                              memory_order_relaxed);
+    }
+    atomic_store_explicit(&q->array, bigger, memory_order_release);
+    return bigger;
+}
+
+bool wsdeque_push(wsdeque_t *q, element_t *e)
+{
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&q->top, memory_order_acquire);
+    struct wsarray *a = atomic_load_explicit(&q->array, memory_order_relaxed);
+
+    if (b - t > (int64_t) a->mask && !(a = grow(q, a, t, b)))
+        return false;
+    atomic_store_explicit(&a->slot[b & a->mask], e, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+element_t *wsdeque_pop(wsdeque_t *q)
+{
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+    struct wsarray *a = atomic_load_explicit(&q->array, memory_order_relaxed);
+
+    /* Claim the bottom slot before looking at the top */
+    atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+    element_t *e = NULL;
+    if (t <= b) {
+        e = atomic_load_explicit(&a->slot[b & a->mask], memory_order_relaxed);
+        if (t == b) {
+            /* The last element: race the thieves for it */
+            if (!atomic_compare_exchange_strong_explicit(
+                    &q->top, &t, t + 1, memory_order_seq_cst,
+                    memory_order_relaxed))
+                e = NULL;
+            atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    }
+    return e;
+}
+
+element_t *wsdeque_steal(wsdeque_t *q)
+{
+    int64_t t = atomic_load_explicit(&q->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+    if (t >= b)
+        return NULL;
+
+    struct wsarray *a = atomic_load_explicit(&q->array, memory_order_acquire);
+    element_t *e =
+        atomic_load_explicit(&a->slot[t & a->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return NULL;
+    return e;
+}
@@ -0,0 +1,62 @@
+#ifndef LAB0_WSDEQUE_H
+#define LAB0_WSDEQUE_H
+
+/* Work-stealing deque of elements, after Chase and Lev, "Dynamic Circular
+ * Work-Stealing Deque" (SPAA 2005), with the memory orderings of Lê et al.,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ *
+ * One owner thread pushes and pops at the bottom end, as q_insert_tail() and
+ * q_remove_tail() would, without locks and without atomic read-modify-write
+ * operations except when taking the last element. Any other thread may
+ * steal from the top end, as q_remove_head() would, with a compare-and-swap
+ * on the top index. The elements live in a circular array of pointers, which
+ * the owner doubles when it fills up. Thieves may still be reading an array
+ * replaced that way, so replaced arrays are only freed with the deque.
+ *
+ * Memory comes from the C library, not from the harness, which is not
+ * thread-safe.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+typedef struct wsdeque wsdeque_t;
+
+/* Create an empty deque, %NULL for allocation failed */
+wsdeque_t *wsdeque_new(void);
+
+/* Free the deque, no effect if @q is NULL. Elements still queued are left
+ * to their owner, and no thread may use the deque any longer.
+ */
+void wsdeque_free(wsdeque_t *q);
+
+/**
+ * wsdeque_push() - Push an element at the bottom, owner only
+ * @q: the deque
+ * @e: the element
+ *
+ * Return: true for success, false if the array could not grow
+ */
+bool wsdeque_push(wsdeque_t *q, element_t *e);
+
+/**
+ * wsdeque_pop() - Pop the element at the bottom, owner only
+ * @q: the deque
+ *
+ * Return: the element pushed last, %NULL if the deque is empty or a thief
+ * took the last element first
+ */
+element_t *wsdeque_pop(wsdeque_t *q);
+
+/**
+ * wsdeque_steal() - Steal the element at the top, from any thread
+ * @q: the deque
+ *
+ * Return: the oldest element, %NULL if the deque is empty or another thread
+ * took it first
+ */
+element_t *wsdeque_steal(wsdeque_t *q);
+
+#endif /* LAB0_WSDEQUE_H */
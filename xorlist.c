@@ -0,0 +1,186 @@
+/* XOR-linked queue of strings, see xorlist.h */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "xorlist.h"
+
+/* Sorted runs of 1 << i nodes pending in bin i of xq_sort(), which is
+ * enough for any queue fitting in memory
+ */
+#define XQ_SORT_BINS 64
+
+xqueue_t *xq_new(void)
+{
+    xqueue_t *q = malloc(sizeof(*q));
+    if (!q)
+        return NULL;
+    q->head = q->tail = NULL;
+    q->size = 0;
+    return q;
+}
+
+void xq_free(xqueue_t *q)
+{
+    if (!q)
+        return;
+
+    /* Stepping off a node only needs its address, not its contents */
+    xq_iter_t it = xq_begin(q, false);
+    while (it.cur) {
+        xnode_t *node = it.cur;
+        xq_step(&it);
+        free(node);
+    }
+    free(q);
+}
+
+/* Link a node holding a copy of @s before *@end, the node at one end, whose
+ * other end is *@other. The list being symmetric, the same code serves both
+ * ends.
+ */
+static bool xq_insert(xqueue_t *q,
+                      const char *s,
+                      xnode_t **end,
+                      xnode_t **other)
+{
+    size_t len = strlen(s) + 1;
+    xnode_t *node = malloc(sizeof(*node) + len);
+    if (!node)
+        return false;
+    memcpy(node->value, s, len);
+
+    node->link = (uintptr_t) *end;
+    if (*end)
+        (*end)->link ^= (uintptr_t) node;
+    else
+        *other = node;
+    *end = node;
+    q->size++;
+    return true;
+}
+
+bool xq_insert_head(xqueue_t *q, const char *s)
+{
+    return q && xq_insert(q, s, &q->head, &q->tail);
+}
+
+bool xq_insert_tail(xqueue_t *q, const char *s)
+{
+    return q && xq_insert(q, s, &q->tail, &q->head);
+}
+
+/* Unlink and release the node at *@end, see xq_insert() */
+static bool xq_remove(xqueue_t *q,
+                      char *sp,
+                      size_t bufsize,
+                      xnode_t **end,
+                      xnode_t **other)
+{
+    xnode_t *node = *end;
+    if (!node)
+        return false;
+
+    /* An end node has a single neighbour, which is its whole link */
+    xnode_t *next = (xnode_t *) node->link;
+    if (next)
+        next->link ^= (uintptr_t) node;
+    else
+        *other = NULL;
+    *end = next;
+    q->size--;
+
+    if (sp) {
+        size_t len = strlen(node->value);
+        if (len > bufsize - 1)
+            len = bufsize - 1;
+        memcpy(sp, node->value, len);
+        sp[len] = '\0';
+    }
+    free(node);
+    return true;
+}
+
+bool xq_remove_head(xqueue_t *q, char *sp, size_t bufsize)
+{
+    return q && xq_remove(q, sp, bufsize, &q->head, &q->tail);
+}
+
+bool xq_remove_tail(xqueue_t *q, char *sp, size_t bufsize)
+{
+    return q && xq_remove(q, sp, bufsize, &q->tail, &q->head);
+}
+
+void xq_reverse(xqueue_t *q)
+{
+    if (!q)
+        return;
+    xnode_t *head = q->head;
+    q->head = q->tail;
+    q->tail = head;
+}
+
+/* While sorting, links hold plain next pointers */
+static inline xnode_t *xq_next(const xnode_t *node)
+{
+    return (xnode_t *) node->link;
+}
+
+/* Merge two null-terminated runs, @a coming first in the queue */
+static xnode_t *xq_merge(xnode_t *a, xnode_t *b, bool descend)
+{
+    uintptr_t head = 0, *tail = &head;
+    while (a && b) {
+        int cmp = strcmp(a->value, b->value);
+        xnode_t **first = (descend ? cmp < 0 : cmp > 0) ? &b : &a;
+        *tail = (uintptr_t) *first;
+        tail = &(*first)->link;
+        *first = xq_next(*first);
+    }
+    *tail = (uintptr_t) (a ? a : b);
+    return (xnode_t *) head;
+}
+
+void xq_sort(xqueue_t *q, bool descend)
+{
+    if (!q || q->size < 2)
+        return;
+
+    /* Turn the links into next pointers, feeding the nodes to the bins */
+    xnode_t *bin[XQ_SORT_BINS] = {NULL};
+    xnode_t *prev = NULL, *node = q->head;
+    while (node) {
+        xnode_t *next = xq_other(node, prev);
+        prev = node;
+
+        /* Carry the new node up, merging it with the earlier runs */
+        node->link = 0;
+        xnode_t *run = node;
+        int i = 0;
+        for (; bin[i]; i++) {
+            run = xq_merge(bin[i], run, descend);
+            bin[i] = NULL;
+        }
+        bin[i] = run;
+        node = next;
+    }
+
+    /* Lower bins hold later nodes */
+    xnode_t *head = NULL;
+    for (int i = 0; i < XQ_SORT_BINS; i++) {
+        if (bin[i])
+            head = xq_merge(bin[i], head, descend);
+    }
+
+    /* Back to XOR links */
+    prev = NULL;
+    for (node = head; node;) {
+        xnode_t *next = xq_next(node);
+        node->link = (uintptr_t) prev ^ (uintptr_t) next;
+        prev = node;
+        node = next;
+    }
+    q->head = head;
+    q->tail = prev;
+}
@@ -0,0 +1,134 @@
+#ifndef LAB0_XORLIST_H
+#define LAB0_XORLIST_H
+
+/* XOR-linked queue of strings, a compact counterpart of queue.c for very
+ * large queues.
+ *
+ * Each node stores a single link, the address of the node before it XOR the
+ * address of the node after it, and the string right behind that: 8 bytes of
+ * metadata per element where element_t takes 48. Walking the queue from
+ * either end recovers each next node from the link and the node just left.
+ * Nodes cannot be reached from the middle, so the queue supports only what a
+ * walk from the ends allows: O(1) insertion and removal at both ends, walks
+ * in both directions, O(1) reversal, which swaps the ends, and a merge sort.
+ *
+ * Memory comes from the harness, as for queue.c.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * xnode_t - Node of an XOR-linked queue
+ * @link: address of the previous node XOR address of the next one, taking
+ *        the missing neighbour of an end node as %NULL
+ * @value: the string
+ */
+typedef struct {
+    uintptr_t link;
+    char value[];
+} xnode_t;
+
+/**
+ * xqueue_t - XOR-linked queue
+ * @head: first node, %NULL if the queue is empty
+ * @tail: last node, %NULL if the queue is empty
+ * @size: the number of nodes
+ */
+typedef struct {
+    xnode_t *head, *tail;
+    size_t size;
+} xqueue_t;
+
+/**
+ * xq_iter_t - Position of a walk over an XOR-linked queue
+ * @prev: node walked over last, %NULL at the start
+ * @cur: current node, %NULL past the end
+ */
+typedef struct {
+    xnode_t *prev, *cur;
+} xq_iter_t;
+
+/* The neighbour of @node on the other side from @from */
+static inline xnode_t *xq_other(const xnode_t *node, const xnode_t *from)
+{
+    return (xnode_t *) (node->link ^ (uintptr_t) from);
+}
+
+static inline xq_iter_t xq_begin(const xqueue_t *q, bool backward)
+{
+    return (xq_iter_t){NULL, backward ? q->tail : q->head};
+}
+
+static inline void xq_step(xq_iter_t *it)
+{
+    xnode_t *next = xq_other(it->cur, it->prev);
+    it->prev = it->cur;
+    it->cur = next;
+}
+
+/**
+ * xq_for_each - Walk the nodes of a queue from head to tail
+ * @it: the xq_iter_t used as a cursor, whose @cur is the current node
+ * @q: the queue
+ */
+#define xq_for_each(it, q) \
+    for (it = xq_begin(q, false); (it).cur; xq_step(&(it)))
+
+/**
+ * xq_for_each_reverse - Walk the nodes of a queue from tail to head
+ * @it: the xq_iter_t used as a cursor, whose @cur is the current node
+ * @q: the queue
+ */
+#define xq_for_each_reverse(it, q) \
+    for (it = xq_begin(q, true); (it).cur; xq_step(&(it)))
+
+/* Create an empty queue, %NULL for allocation failed */
+xqueue_t *xq_new(void);
+
+/* Free the queue and its strings, no effect if @q is NULL */
+void xq_free(xqueue_t *q);
+
+/**
+ * xq_insert_head() - Insert a copy of a string at head of queue
+ * @q: the queue
+ * @s: the string
+ *
+ * Return: true for success, false for allocation failed or queue is NULL
+ */
+bool xq_insert_head(xqueue_t *q, const char *s);
+
+/* Same as xq_insert_head(), at tail of queue */
+bool xq_insert_tail(xqueue_t *q, const char *s);
+
+/**
+ * xq_remove_head() - Remove and release the node at head of queue
+ * @q: the queue
+ * @sp: buffer for the string of the node, or %NULL
+ * @bufsize: size of @sp
+ *
+ * The string is copied to @sp, truncated to @bufsize - 1 bytes and null
+ * terminated, before the node is freed.
+ *
+ * Return: true for success, false if queue is NULL or empty
+ */
+bool xq_remove_head(xqueue_t *q, char *sp, size_t bufsize);
+
+/* Same as xq_remove_head(), at tail of queue */
+bool xq_remove_tail(xqueue_t *q, char *sp, size_t bufsize);
+
+/* Reverse the queue in O(1) time, no effect if @q is NULL */
+void xq_reverse(xqueue_t *q);
+
+/**
+ * xq_sort() - Sort the queue by strcmp() order, stably
+ * @q: the queue
+ * @descend: whether to sort in descending order
+ *
+ * Bottom-up merge sort, relinking the nodes without allocating. No effect if
+ * queue is NULL or has fewer than two nodes.
+ */
+void xq_sort(xqueue_t *q, bool descend);
+
+#endif /* LAB0_XORLIST_H */